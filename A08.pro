@@ -18,17 +18,16 @@ QT      += core gui opengl      # Wichtig zum Debuggen
 
 LIBS    += -lOpengl32           # Wichtig zum Debuggen
 
+# Simulation core (physics, courses, obstacles)
+include(simcore.pri)
+
 SOURCES += main.cpp\
            mainwindow.cpp \
-           minigolf.cpp \
-           obstacles.cpp \
-           oglwidget.cpp \
-           simulation.cpp
+           meshrenderer.cpp \
+           oglwidget.cpp
 
 HEADERS += mainwindow.h \
-           minigolf.hpp \
-           obstacles.hpp \
-           oglwidget.h \
-           simulation.hpp
+           meshrenderer.h \
+           oglwidget.h
 
 FORMS   += mainwindow.ui
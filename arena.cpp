@@ -0,0 +1,42 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace golf {
+
+    namespace {
+        thread_local Arena* currentArena = nullptr;
+    }
+
+    void* Arena::allocate(size_t size, size_t align) {
+        if (!blocks.empty()) {
+            Block& block = blocks.back();
+            uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+            size_t offset = ((base + used + align - 1) & ~(align - 1)) - base;
+            if (offset + size <= block.size) {
+                used = offset + size;
+                bytesAllocated += size;
+                return block.data.get() + offset;
+            }
+        }
+
+        // objects bigger than a block get one of their own
+        size_t capacity = std::max(blockSize, size + align);
+        blocks.push_back({std::unique_ptr<char[]>(new char[capacity]), capacity});
+        used = 0;
+        return allocate(size, align);
+    }
+
+    Arena::Scope::Scope(Arena& arena) : previous(currentArena) {
+        currentArena = &arena;
+    }
+
+    Arena::Scope::~Scope() {
+        currentArena = previous;
+    }
+
+    Arena* Arena::current() {
+        return currentArena;
+    }
+
+}
@@ -0,0 +1,60 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace golf
+{
+
+    // monotonic region, memory is handed out in order from big blocks and only given back all at once
+    // objects in it still need their destructors run, see buildLevel
+    class Arena
+    {
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        // bytes used of the last block
+        size_t used = 0;
+        size_t blockSize;
+        size_t bytesAllocated = 0;
+
+    public:
+        explicit Arena(size_t blockSize = 64 * 1024) : blockSize(blockSize) {}
+
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+
+        // align has to be a power of two
+        void *allocate(size_t size, size_t align);
+        size_t getBytesAllocated() const { return bytesAllocated; }
+        size_t getBlockCount() const { return blocks.size(); }
+
+        // while a scope is alive, SimObjects created on its thread are allocated in the arena
+        class Scope
+        {
+        private:
+            Arena *previous;
+
+        public:
+            explicit Scope(Arena &arena);
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+        };
+
+        // arena of the innermost scope on this thread, nullptr if there is none
+        static Arena *current();
+    };
+
+}
+
+#endif // ARENA_HPP
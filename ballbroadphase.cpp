@@ -0,0 +1,84 @@
+#include "ballbroadphase.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    unsigned long long BallBroadphase::pairKey(int a, int b) {
+        if (a > b) std::swap(a, b);
+        return (static_cast<unsigned long long>(a) << 32) | static_cast<unsigned int>(b);
+    }
+
+    void BallBroadphase::clear() {
+        endpoints.clear();
+        boxes.clear();
+        pairCache.clear();
+    }
+
+    void BallBroadphase::rebuild() {
+        endpoints.clear();
+        pairCache.clear();
+        for (size_t i = 0; i < boxes.size(); i++) {
+            endpoints.push_back({boxes[i].min.x, static_cast<int>(i), false});
+            endpoints.push_back({boxes[i].max.x, static_cast<int>(i), true});
+        }
+        // min ends first on ties, touching intervals count as overlapping
+        std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& a, const Endpoint& b) {
+            return a.value < b.value || (a.value == b.value && !a.isMax && b.isMax);
+        });
+
+        // every box that opens while another one is open overlaps it on x
+        std::vector<int> open;
+        for (const Endpoint& endpoint : endpoints) {
+            if (endpoint.isMax) {
+                open.erase(std::find(open.begin(), open.end(), endpoint.box));
+                continue;
+            }
+            for (int other : open) addPair(endpoint.box, other);
+            open.push_back(endpoint.box);
+        }
+    }
+
+    void BallBroadphase::update(const std::vector<AABB>& newBoxes) {
+        bool sameCount = newBoxes.size() == boxes.size();
+        boxes = newBoxes;
+        if (!sameCount) {
+            rebuild();
+            return;
+        }
+
+        for (Endpoint& endpoint : endpoints) {
+            endpoint.value = endpoint.isMax ? boxes[endpoint.box].max.x : boxes[endpoint.box].min.x;
+        }
+
+        // insertion sort, each swap moves an end past another one
+        for (size_t i = 1; i < endpoints.size(); i++) {
+            Endpoint moving = endpoints[i];
+            size_t j = i;
+            while (j > 0) {
+                const Endpoint& passed = endpoints[j - 1];
+                bool before = passed.value > moving.value || (passed.value == moving.value && passed.isMax && !moving.isMax);
+                if (!before) break;
+
+                // a min end moving below a max end starts an overlap, a max end moving below a min end ends one
+                if (!moving.isMax && passed.isMax) addPair(moving.box, passed.box);
+                else if (moving.isMax && !passed.isMax) removePair(moving.box, passed.box);
+
+                endpoints[j] = passed;
+                j--;
+            }
+            endpoints[j] = moving;
+        }
+    }
+
+    void BallBroadphase::getPairs(std::vector<std::pair<int, int>>& pairs) const {
+        pairs.clear();
+        for (unsigned long long key : pairCache) {
+            int a = static_cast<int>(key >> 32);
+            int b = static_cast<int>(key & 0xffffffffULL);
+            if (boxes[a].overlaps(boxes[b])) pairs.emplace_back(a, b);
+        }
+        // the cache is unordered, keep the collision order stable between runs
+        std::sort(pairs.begin(), pairs.end());
+    }
+
+}
@@ -0,0 +1,48 @@
+#ifndef BALLBROADPHASE_HPP
+#define BALLBROADPHASE_HPP
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    // incremental sweep and prune over moving boxes, for ball to ball tests
+    // the box ends on x are kept sorted between steps, balls move little per step,
+    // so an insertion sort fixes the order in close to linear time
+    // every swap of a min and a max end updates a cache of the pairs that overlap on x
+    class BallBroadphase
+    {
+
+    private:
+        struct Endpoint
+        {
+            double value;
+            int box;
+            bool isMax;
+        };
+
+        std::vector<Endpoint> endpoints;
+        std::vector<AABB> boxes;
+        // pairs whose x intervals overlap, first index is always the smaller one
+        std::unordered_set<unsigned long long> pairCache;
+
+        static unsigned long long pairKey(int a, int b);
+        void rebuild();
+        void addPair(int a, int b) { pairCache.insert(pairKey(a, b)); }
+        void removePair(int a, int b) { pairCache.erase(pairKey(a, b)); }
+
+    public:
+        // boxes are indexed like the balls, a different count starts over with a full sort
+        void update(const std::vector<AABB> &boxes);
+        // pairs whose boxes overlap on all axes, sorted, first index smaller
+        void getPairs(std::vector<std::pair<int, int>> &pairs) const;
+        void clear();
+        size_t getCachedPairCount() const { return pairCache.size(); }
+    };
+
+}
+
+#endif // BALLBROADPHASE_HPP
@@ -0,0 +1,136 @@
+#include "batchsimulator.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    BatchSimulator::BatchSimulator(PhysicsWorld& physics, TaskPool& pool, const Sphere& ball, int count)
+        : physics(physics), pool(pool), ball(ball) {
+        this->ball.setVelocity(Vec3(0));
+        this->ball.wake();
+        resize(count);
+        resetAll(this->ball.getPosition());
+    }
+
+    void BatchSimulator::resize(int count) {
+        state.x.resize(count);
+        state.y.resize(count);
+        state.z.resize(count);
+        state.vx.resize(count);
+        state.vy.resize(count);
+        state.vz.resize(count);
+        state.holed.resize(count);
+        state.outOfBounds.resize(count);
+        state.sleeping.resize(count);
+        state.restingSteps.resize(count);
+        state.stillSteps.resize(count);
+        state.stillX.resize(count);
+        state.stillY.resize(count);
+        state.stillZ.resize(count);
+        state.steps.resize(count);
+    }
+
+    void BatchSimulator::reset(int i, const Vec3& position) {
+        state.x[i] = position.x;
+        state.y[i] = position.y;
+        state.z[i] = position.z;
+        state.vx[i] = 0;
+        state.vy[i] = 0;
+        state.vz[i] = 0;
+        state.holed[i] = 0;
+        state.outOfBounds[i] = 0;
+        state.sleeping[i] = 0;
+        state.restingSteps[i] = 0;
+        state.stillSteps[i] = 0;
+        state.steps[i] = 0;
+    }
+
+    void BatchSimulator::resetAll(const Vec3& position) {
+        for (int i = 0; i < getCount(); i++) {
+            reset(i, position);
+        }
+    }
+
+    void BatchSimulator::setVelocity(int i, const Vec3& velocity) {
+        state.vx[i] = velocity.x;
+        state.vy[i] = velocity.y;
+        state.vz[i] = velocity.z;
+        state.sleeping[i] = 0;
+        state.restingSteps[i] = 0;
+        state.stillSteps[i] = 0;
+    }
+
+    void BatchSimulator::step(double dt) {
+        PROFILE_SCOPE("BatchSimulator::step");
+
+        // built lazily otherwise, the chunks read it from every worker
+        physics.getGame().prepareCollision();
+
+        int count = getCount();
+        int chunks = (count + chunkSize - 1) / chunkSize;
+        pool.parallelFor(chunks, [&](int chunk) {
+            int first = chunk * chunkSize;
+            stepChunk(first, std::min(first + chunkSize, count), dt);
+        });
+    }
+
+    void BatchSimulator::stepChunk(int first, int end, double dt) {
+        Course& course = physics.getGame().getCourse();
+        Sphere sphere = ball;
+
+        for (int i = first; i < end; i++) {
+            if (isSettled(i)) continue;
+
+            // load, step and store, the scratch ball carries nothing over from the last environment
+            sphere.setPosition(Vec3(state.x[i], state.y[i], state.z[i]));
+            sphere.storePreviousPosition();
+            sphere.setVelocity(Vec3(state.vx[i], state.vy[i], state.vz[i]));
+            sphere.wake();
+            sphere.setRestingSteps(state.restingSteps[i]);
+            sphere.setStill(state.stillSteps[i], Vec3(state.stillX[i], state.stillY[i], state.stillZ[i]));
+
+            // PhysicsWorld::advanceBall without the spin, the orientation is only drawn
+            physics.applyGravity(sphere, dt);
+            physics.integrate(sphere, dt);
+            physics.updateSleep(sphere, physics.getGame().collide(sphere));
+            state.steps[i]++;
+
+            const Vec3& position = sphere.getPosition();
+            const Vec3& velocity = sphere.getVelocity();
+            state.x[i] = position.x;
+            state.y[i] = position.y;
+            state.z[i] = position.z;
+            state.vx[i] = velocity.x;
+            state.vy[i] = velocity.y;
+            state.vz[i] = velocity.z;
+            state.sleeping[i] = sphere.isSleeping();
+            state.restingSteps[i] = sphere.getRestingSteps();
+            state.stillSteps[i] = sphere.getStillSteps();
+            const Vec3& still = sphere.getStillAnchor();
+            state.stillX[i] = still.x;
+            state.stillY[i] = still.y;
+            state.stillZ[i] = still.z;
+
+            if (course.isInHole(sphere))
+                state.holed[i] = 1;
+            else if (position.y < outOfBoundsHeight)
+                state.outOfBounds[i] = 1;
+        }
+    }
+
+    int BatchSimulator::run(double dt, int maxSteps) {
+        int steps = 0;
+        while (steps < maxSteps) {
+            bool running = false;
+            for (int i = 0; i < getCount() && !running; i++) {
+                running = !isSettled(i);
+            }
+            if (!running) break;
+
+            step(dt);
+            steps++;
+        }
+        return steps;
+    }
+
+}
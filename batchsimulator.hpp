@@ -0,0 +1,80 @@
+#ifndef BATCHSIMULATOR_HPP
+#define BATCHSIMULATOR_HPP
+
+#include "physics.hpp"
+#include "taskpool.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace golf
+{
+
+    // steps many independent balls on the course of one game, one ball per environment
+    // the environments share the static geometry and keep nothing but their ball state,
+    // stored as one flat array per component so it can be read back or written without going through objects
+    // like ShotSolver it only reads the course, moving obstacles stay where they are,
+    // so it has to run on the thread that steps the game, between two steps
+    class BatchSimulator
+    {
+
+    public:
+        // state of all environments, index i is environment i
+        struct State
+        {
+            std::vector<Real> x, y, z;
+            std::vector<Real> vx, vy, vz;
+            // an environment is done once its ball is holed or fell off, it is not stepped after that
+            std::vector<uint8_t> holed;
+            std::vector<uint8_t> outOfBounds;
+            std::vector<uint8_t> sleeping;
+            // see Sphere::addRestingStep and Sphere::addStillStep
+            std::vector<int> restingSteps;
+            std::vector<int> stillSteps;
+            std::vector<Real> stillX, stillY, stillZ;
+            // steps taken since the last reset
+            std::vector<int> steps;
+        };
+
+    private:
+        PhysicsWorld &physics;
+        TaskPool &pool;
+        // radius, bounce factor and density of every ball
+        Sphere ball;
+        State state;
+
+        // environments stepped by one task, each task reuses one scratch ball for all of them
+        int chunkSize = 64;
+
+        void resize(int count);
+        void stepChunk(int first, int end, double dt);
+
+    public:
+        BatchSimulator(PhysicsWorld &physics, TaskPool &pool, const Sphere &ball, int count);
+
+        int getCount() const { return static_cast<int>(state.x.size()); }
+        const State &getState() const { return state; }
+        void setChunkSize(int chunkSize) { this->chunkSize = chunkSize; }
+
+        // puts the ball of an environment at rest at the position and clears its flags
+        void reset(int i, const Vec3 &position);
+        void resetAll(const Vec3 &position);
+        // shoots the ball of an environment, it wakes up if it was sleeping
+        void setVelocity(int i, const Vec3 &velocity);
+
+        // advances every environment that is neither done nor sleeping by dt seconds
+        // the same physics as PhysicsWorld::advanceBall, then the hole and out of bounds checks of Game::tick
+        void step(double dt);
+        // steps until every environment is done or sleeping, at most maxSteps times, returns the steps taken
+        int run(double dt, int maxSteps);
+        // true if the environment will not move without a new shot
+        bool isSettled(int i) const { return state.holed[i] || state.outOfBounds[i] || state.sleeping[i]; }
+        Vec3 getPosition(int i) const { return Vec3(state.x[i], state.y[i], state.z[i]); }
+        Vec3 getVelocity(int i) const { return Vec3(state.vx[i], state.vy[i], state.vz[i]); }
+
+        // balls below this height are out of bounds, same as Game::tick
+        static constexpr double outOfBoundsHeight = -10;
+    };
+
+}
+
+#endif // BATCHSIMULATOR_HPP
@@ -0,0 +1,277 @@
+#include "simulation.hpp"
+#include "minigolf.hpp"
+#include "physics.hpp"
+#include "timestep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// every allocation of the process is counted, the benchmarks report the ones made while they run
+static std::atomic<unsigned long long> allocations{0};
+
+static void* countedAlloc(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+
+    // results are written here so the compiler can not drop the work
+    volatile double sink;
+
+    struct Result
+    {
+        std::string group;
+        std::string name;
+        unsigned long long iterations;
+        double nsPerOp;
+        double allocsPerOp;
+        // only for the full shots, negative otherwise
+        double stepsPerSec = -1;
+    };
+
+    std::vector<Result> results;
+
+    using Clock = std::chrono::steady_clock;
+
+    // runs body for every index in [0, iterations) a few times and keeps the median run
+    // a template so body is inlined into the loop, the vec3 ops take a few ns and an indirect call would be most of it
+    template <typename Body>
+    void measure(const std::string& group, const std::string& name, unsigned long long iterations, const Body& body)
+    {
+        constexpr int runs = 5;
+
+        // warm up caches and lazily built data
+        for (unsigned long long i = 0; i < std::min(iterations, 1000ULL); i++)
+            body(i);
+
+        std::vector<double> times;
+        unsigned long long allocated = 0;
+        for (int run = 0; run < runs; run++)
+        {
+            unsigned long long before = allocations.load();
+            auto start = Clock::now();
+            for (unsigned long long i = 0; i < iterations; i++)
+                body(i);
+            auto end = Clock::now();
+            allocated += allocations.load() - before;
+            times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        std::sort(times.begin(), times.end());
+
+        Result result;
+        result.group = group;
+        result.name = name;
+        result.iterations = iterations;
+        result.nsPerOp = times[runs / 2] / iterations;
+        result.allocsPerOp = static_cast<double>(allocated) / (iterations * runs);
+        results.push_back(result);
+        std::cerr << group << "/" << name << ": " << result.nsPerOp << " ns/op" << std::endl;
+    }
+
+    void benchVec3()
+    {
+        // inputs vary per iteration so nothing can be folded away
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> u(-10, 10);
+        std::vector<Vec3> values(1024);
+        for (Vec3& v : values)
+            v = Vec3(u(rng), u(rng), u(rng));
+
+        constexpr unsigned long long n = 10 * 1000 * 1000;
+        measure("vec3", "add", n, [&](unsigned long long i) {
+            sink = (values[i & 1023] + values[(i + 1) & 1023]).x;
+        });
+        measure("vec3", "scale", n, [&](unsigned long long i) {
+            sink = (values[i & 1023] * 1.5).y;
+        });
+        measure("vec3", "dot", n, [&](unsigned long long i) {
+            sink = values[i & 1023].dot(values[(i + 1) & 1023]);
+        });
+        measure("vec3", "cross", n, [&](unsigned long long i) {
+            sink = values[i & 1023].cross(values[(i + 1) & 1023]).z;
+        });
+        measure("vec3", "length", n, [&](unsigned long long i) {
+            sink = values[i & 1023].length();
+        });
+        measure("vec3", "normalized", n, [&](unsigned long long i) {
+            sink = values[i & 1023].normalized().x;
+        });
+    }
+
+    // a collision moves the sphere, so every iteration starts it over
+    // the reset is part of the time, it is the same for all cases
+    void benchCollide(const std::string& group, SimObject& object, const std::string& name, const Vec3& position, const Vec3& velocity)
+    {
+        Sphere sphere(position, 0.4);
+        measure(group, name, 2 * 1000 * 1000, [&](unsigned long long) {
+            sphere.setPosition(position);
+            sphere.setVelocity(velocity);
+            sink = object.collide(sphere);
+        });
+    }
+
+    void benchCollisions()
+    {
+        // default triangle, corners (-1 0 -1), (1 0 -1) and (0 0 1)
+        Triangle triangle;
+        benchCollide("triangle_collide", triangle, "hit", Vec3(0, 0.3, 0), Vec3(0, -1, 0));
+        benchCollide("triangle_collide", triangle, "miss", Vec3(0, 2, 0), Vec3(0, -1, 0));
+        benchCollide("triangle_collide", triangle, "edge", Vec3(0, 0.1, -1.3), Vec3(0, 0, 1));
+        benchCollide("triangle_collide", triangle, "corner", Vec3(-1.2, 0.1, -1.2), Vec3(1, 0, 1));
+
+        // wall along x from -2 to 2, two high
+        Wall wall(-2, 0, 2, 0);
+        benchCollide("wall_collide", wall, "hit", Vec3(0, 1, 0.3), Vec3(0, 0, -1));
+        benchCollide("wall_collide", wall, "miss", Vec3(0, 1, 2), Vec3(0, 0, -1));
+        benchCollide("wall_collide", wall, "edge", Vec3(0, 2.3, 0.1), Vec3(0, -1, 0));
+        benchCollide("wall_collide", wall, "corner", Vec3(2.2, 2.2, 0.1), Vec3(-1, -1, 0));
+    }
+
+    void benchSphere()
+    {
+        Sphere sphere(Vec3(0), 0.4);
+        Sphere other(Vec3(0.6, 0, 0), 0.4);
+        measure("sphere", "bounce", 2 * 1000 * 1000, [&](unsigned long long) {
+            sphere.setPosition(Vec3(0));
+            sphere.setVelocity(Vec3(1, 0, 0));
+            other.setPosition(Vec3(0.6, 0, 0));
+            other.setVelocity(Vec3(-1, 0, 0));
+            sphere.bounce(other);
+            sink = sphere.getVelocity().x;
+        });
+
+        Sphere rolling(Vec3(0), 0.4);
+        measure("sphere", "move", 2 * 1000 * 1000, [&](unsigned long long i) {
+            rolling.setPosition(Vec3(0));
+            rolling.move(Vec3(0.01 * (i & 7), 0, 0.01));
+            sink = rolling.getPosition().x;
+        });
+    }
+
+    void benchCreateFloor()
+    {
+        golf::Game game;
+        auto height = [](double x, double z) { return sin(x) * cos(z) * 0.5; };
+        measure("course", "create_floor", 100, [&](unsigned long long) {
+            std::vector<Triangle*> floor = game.getCourse().createFloor(-10, 10, 0.5, height);
+            sink = floor.size();
+            for (Triangle* triangle : floor)
+                delete triangle;
+        });
+    }
+
+    // plays shots in all directions on a course through the same advance as the app
+    // a shot ends once the game leaves the moving state, the ball rests or is holed
+    void benchShots(const std::string& name, const std::function<golf::Course*(golf::Game&)>& createCourse)
+    {
+        constexpr int directions = 8;
+        constexpr int maxSteps = 60 * 60;
+        golf::FixedTimestep timestep(1.0 / 60);
+
+        unsigned long long steps = 0;
+        unsigned long long allocated = 0;
+        double seconds = 0;
+        for (int d = 0; d < directions; d++)
+        {
+            golf::Game game;
+            golf::PhysicsWorld physics(game);
+            game.setLevel(createCourse(game));
+            game.prepareCollision();
+
+            // the first tick picks the player and the ball drops onto the course
+            unsigned long long step = 0;
+            while (game.getShotState() != golf::ShotState::AIMING && step < 120)
+            {
+                physics.advance(step * timestep.getStepNanoseconds(), timestep.getStep());
+                step++;
+            }
+
+            double angle = d * 2 * PI / directions;
+            game.getController().queueShot(Vec3(cos(angle), 0, sin(angle)) * 2);
+
+            unsigned long long before = allocations.load();
+            auto start = Clock::now();
+            unsigned long long shotSteps = 0;
+            do
+            {
+                physics.advance(step * timestep.getStepNanoseconds(), timestep.getStep());
+                step++;
+                shotSteps++;
+            } while (game.getShotState() == golf::ShotState::MOVING && shotSteps < maxSteps);
+            auto end = Clock::now();
+
+            allocated += allocations.load() - before;
+            seconds += std::chrono::duration<double>(end - start).count();
+            steps += shotSteps;
+        }
+
+        Result result;
+        result.group = "shot";
+        result.name = name;
+        result.iterations = steps;
+        result.nsPerOp = seconds * 1e9 / steps;
+        result.allocsPerOp = static_cast<double>(allocated) / steps;
+        result.stepsPerSec = steps / seconds;
+        results.push_back(result);
+        std::cerr << "shot/" << name << ": " << result.stepsPerSec << " steps/s" << std::endl;
+    }
+
+    void writeJson(std::ostream& out)
+    {
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            out << "    {\"group\": \"" << r.group << "\", \"name\": \"" << r.name << "\""
+                << ", \"iterations\": " << r.iterations
+                << ", \"ns_per_op\": " << r.nsPerOp
+                << ", \"allocs_per_op\": " << r.allocsPerOp;
+            if (r.stepsPerSec >= 0)
+                out << ", \"steps_per_sec\": " << r.stepsPerSec;
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+}
+
+int main()
+{
+    // the game reports shots and holes on cout, which is where the json goes
+    std::ostringstream gameOutput;
+    std::streambuf* coutBuffer = std::cout.rdbuf(gameOutput.rdbuf());
+
+    benchVec3();
+    benchCollisions();
+    benchSphere();
+    benchCreateFloor();
+    benchShots("CourseA8", [](golf::Game& game) { return new golf::CourseA8(game); });
+    benchShots("Course2", [](golf::Game& game) { return new golf::Course2(game); });
+    benchShots("Course3", [](golf::Game& game) { return new golf::Course3(game); });
+    benchShots("Course4", [](golf::Game& game) { return new golf::Course4(game); });
+
+    std::cout.rdbuf(coutBuffer);
+    writeJson(std::cout);
+    return 0;
+}
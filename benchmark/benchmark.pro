@@ -0,0 +1,13 @@
+# Headless benchmarks of the simulation core, next to A08.pro
+# qmake && make, then ./benchmark > results.json
+# the results are written as json to stdout, progress goes to stderr
+
+TEMPLATE = app
+TARGET   = benchmark
+CONFIG  += console release
+CONFIG  -= app_bundle
+
+# Simulation core (physics, courses, obstacles)
+include(../simcore.pri)
+
+SOURCES += benchmark.cpp
@@ -0,0 +1,131 @@
+#include "bvh.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    // number of buckets per axis used to evaluate split candidates
+    constexpr int binCount = 12;
+
+    void BVH::clear() {
+        nodes.clear();
+        indices.clear();
+    }
+
+    void BVH::build(const std::vector<AABB>& boxes, int maxLeafSize) {
+        clear();
+        this->maxLeafSize = maxLeafSize;
+        if (boxes.empty()) return;
+
+        std::vector<Vec3> centers;
+        centers.reserve(boxes.size());
+        indices.reserve(boxes.size());
+        for (size_t i = 0; i < boxes.size(); i++) {
+            centers.push_back(boxes[i].center());
+            indices.push_back(i);
+        }
+
+        // a binary tree never has more than 2n-1 nodes
+        nodes.reserve(boxes.size() * 2);
+        Node root;
+        root.first = 0;
+        root.count = boxes.size();
+        nodes.push_back(root);
+        subdivide(0, boxes, centers, 0);
+        // leaves of several primitives need far fewer nodes than reserved
+        nodes.shrink_to_fit();
+    }
+
+    void BVH::subdivide(int nodeIndex, const std::vector<AABB>& boxes, const std::vector<Vec3>& centers, int depth) {
+
+        // bounds of the node and of the centers of its primitives
+        AABB bounds;
+        AABB centerBounds;
+        int first = nodes[nodeIndex].first;
+        int count = nodes[nodeIndex].count;
+        for (int i = first; i < first + count; i++) {
+            bounds.expand(boxes[indices[i]]);
+            centerBounds.expand(centers[indices[i]]);
+        }
+        nodes[nodeIndex].bounds = bounds;
+
+        if (count <= maxLeafSize || depth >= maxDepth) return;
+
+        // find the cheapest split with the surface area heuristic
+        // cost of a split: area(left) * count(left) + area(right) * count(right)
+        double bestCost = std::numeric_limits<double>::max();
+        int bestAxis = -1;
+        int bestBin = 0;
+        double bestMin = 0;
+        double bestScale = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            double minC = axis == 0 ? centerBounds.min.x : axis == 1 ? centerBounds.min.y : centerBounds.min.z;
+            double maxC = axis == 0 ? centerBounds.max.x : axis == 1 ? centerBounds.max.y : centerBounds.max.z;
+            if (maxC - minC < 1e-9) continue;
+
+            AABB binBounds[binCount];
+            int binCounts[binCount] = {0};
+            double scale = binCount / (maxC - minC);
+            for (int i = first; i < first + count; i++) {
+                const Vec3& c = centers[indices[i]];
+                double value = axis == 0 ? c.x : axis == 1 ? c.y : c.z;
+                int bin = std::min(binCount - 1, static_cast<int>((value - minC) * scale));
+                binCounts[bin]++;
+                binBounds[bin].expand(boxes[indices[i]]);
+            }
+
+            // sweep from the left and from the right to get the cost of every bin boundary
+            double leftArea[binCount - 1];
+            int leftCount[binCount - 1];
+            AABB left;
+            int leftSum = 0;
+            for (int i = 0; i < binCount - 1; i++) {
+                left.expand(binBounds[i]);
+                leftSum += binCounts[i];
+                leftArea[i] = left.surfaceArea();
+                leftCount[i] = leftSum;
+            }
+            AABB right;
+            int rightSum = 0;
+            for (int i = binCount - 1; i > 0; i--) {
+                right.expand(binBounds[i]);
+                rightSum += binCounts[i];
+                double cost = leftArea[i - 1] * leftCount[i - 1] + right.surfaceArea() * rightSum;
+                if (leftCount[i - 1] > 0 && rightSum > 0 && cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = i;
+                    bestMin = minC;
+                    bestScale = scale;
+                }
+            }
+        }
+
+        // stop if no split is cheaper than keeping everything in one leaf
+        if (bestAxis < 0 || bestCost >= bounds.surfaceArea() * count) return;
+
+        auto middle = std::partition(indices.begin() + first, indices.begin() + first + count, [&](int index) {
+            const Vec3& c = centers[index];
+            double value = bestAxis == 0 ? c.x : bestAxis == 1 ? c.y : c.z;
+            return std::min(binCount - 1, static_cast<int>((value - bestMin) * bestScale)) < bestBin;
+        });
+        int leftCount = middle - (indices.begin() + first);
+        if (leftCount == 0 || leftCount == count) return;
+
+        int leftIndex = nodes.size();
+        Node leftNode;
+        leftNode.first = first;
+        leftNode.count = leftCount;
+        Node rightNode;
+        rightNode.first = first + leftCount;
+        rightNode.count = count - leftCount;
+        nodes.push_back(leftNode);
+        nodes.push_back(rightNode);
+
+        nodes[nodeIndex].first = leftIndex;
+        nodes[nodeIndex].count = 0;
+
+        subdivide(leftIndex, boxes, centers, depth + 1);
+        subdivide(leftIndex + 1, boxes, centers, depth + 1);
+    }
+
+}
@@ -0,0 +1,91 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <cassert>
+#include <vector>
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    // a static bounding volume hierarchy over a set of boxes
+    // built once with the surface area heuristic, queried with a box
+    class BVH
+    {
+
+    public:
+        struct Node
+        {
+            AABB bounds;
+            // leaf: index of the first primitive in indices, inner node: index of the left child
+            // the right child always follows the left one
+            int first = 0;
+            // number of primitives, 0 for inner nodes
+            int count = 0;
+        };
+
+    private:
+        std::vector<Node> nodes;
+        // primitive indices, reordered so every leaf references a contiguous range
+        std::vector<int> indices;
+
+        // leaves with this many primitives or less are never split
+        int maxLeafSize = 2;
+
+        void subdivide(int nodeIndex, const std::vector<AABB> &boxes, const std::vector<Vec3> &centers, int depth);
+
+    public:
+        // nodes this deep become leaves whatever their size, skewed input would otherwise split one primitive at a time
+        static constexpr int maxDepth = 48;
+
+        // larger leaves suit callers that scan a leaf in batches
+        void build(const std::vector<AABB> &boxes, int maxLeafSize = 2);
+        void clear();
+        bool isEmpty() const { return nodes.empty(); }
+        const std::vector<Node> &getNodes() const { return nodes; }
+        const std::vector<int> &getIndices() const { return indices; }
+
+        // calls visit(first, count) for every leaf that overlaps the query box
+        // first and count are a range in getIndices(), callers that reorder their primitives
+        // in that order get contiguous runs they can scan linearly
+        template <typename Visitor>
+        void queryLeaves(const AABB &box, Visitor &&visit) const
+        {
+            if (nodes.empty())
+                return;
+
+            // holds at most one pending sibling per level below the current node
+            int stack[maxDepth + 1];
+            int stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize > 0)
+            {
+                const Node &node = nodes[stack[--stackSize]];
+                if (!node.bounds.overlaps(box))
+                    continue;
+                if (node.count > 0)
+                {
+                    visit(node.first, node.count);
+                    continue;
+                }
+                assert(stackSize + 2 <= maxDepth + 1);
+                stack[stackSize++] = node.first + 1;
+                stack[stackSize++] = node.first;
+            }
+        }
+
+        // calls visit(primitiveIndex) for the primitives of every leaf that overlaps the query box
+        // a visited primitive may still miss the box, the caller runs the exact test
+        template <typename Visitor>
+        void query(const AABB &box, Visitor &&visit) const
+        {
+            queryLeaves(box, [&](int first, int count) {
+                for (int i = first; i < first + count; i++)
+                    visit(indices[i]);
+            });
+        }
+    };
+
+}
+
+#endif // BVH_HPP
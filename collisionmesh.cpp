@@ -0,0 +1,198 @@
+#include "collisionmesh.hpp"
+#include <algorithm>
+#include "sweep.hpp"
+
+namespace golf {
+
+    void CollisionMesh::clear() {
+        triA.clear();
+        triB.clear();
+        triC.clear();
+        triNormal.clear();
+        triMaterial.clear();
+        faces.clear();
+        quadCorners.clear();
+        quadBasis.clear();
+        materials.clear();
+        triangleTree.clear();
+        quadTree.clear();
+    }
+
+    unsigned short CollisionMesh::addMaterial(const Material& material) {
+        // courses only use a handful of surfaces, a linear search is fine
+        for (size_t i = 0; i < materials.size(); i++) {
+            const Material& m = materials[i];
+            if (m.surface.bounceFactor == material.surface.bounceFactor &&
+                m.surface.frictionCoefficient == material.surface.frictionCoefficient &&
+                m.faceCollisionOnly == material.faceCollisionOnly)
+                return i;
+        }
+        materials.push_back(material);
+        return materials.size() - 1;
+    }
+
+    void CollisionMesh::addTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& normal, const Surface& surface, bool faceCollisionOnly) {
+        triA.push_back(a);
+        triB.push_back(b);
+        triC.push_back(c);
+        triNormal.push_back(normal);
+        Material material;
+        material.surface = surface;
+        material.faceCollisionOnly = faceCollisionOnly;
+        triMaterial.push_back(addMaterial(material));
+    }
+
+    void CollisionMesh::addQuad(const std::array<Vec3, 4>& corners, const Vec3& normal) {
+        quadCorners.push_back(corners);
+        quadBasis.push_back(WallBasis(corners.data(), normal));
+    }
+
+    template <typename T>
+    void CollisionMesh::reorder(std::vector<T>& values, const std::vector<int>& order) {
+        std::vector<T> sorted;
+        sorted.reserve(values.size());
+        for (int index : order) sorted.push_back(values[index]);
+        values.swap(sorted);
+    }
+
+    void CollisionMesh::build() {
+
+        // triangles
+        std::vector<AABB> bounds;
+        bounds.reserve(triA.size());
+        for (size_t i = 0; i < triA.size(); i++) {
+            AABB box;
+            box.expand(triA[i]);
+            box.expand(triB[i]);
+            box.expand(triC[i]);
+            bounds.push_back(box);
+        }
+        // leaves of up to eight triangles, two batches of the face kernel
+        triangleTree.build(bounds, 8);
+        const auto& triOrder = triangleTree.getIndices();
+        reorder(triA, triOrder);
+        reorder(triB, triOrder);
+        reorder(triC, triOrder);
+        reorder(triNormal, triOrder);
+        reorder(triMaterial, triOrder);
+
+        faces.clear();
+        faces.reserve(triA.size());
+        for (size_t i = 0; i < triA.size(); i++) {
+            TriangleBasis basis(triA[i], triB[i], triC[i]);
+            const Vec3& a = triA[i];
+            const Vec3& n = triNormal[i];
+            double corner[3] = {a.x, a.y, a.z};
+            double normal[3] = {n.x, n.y, n.z};
+            double edge0[3] = {basis.v0.x, basis.v0.y, basis.v0.z};
+            double edge1[3] = {basis.v1.x, basis.v1.y, basis.v1.z};
+            faces.push(corner, normal, edge0, edge1, basis.dot00, basis.dot01, basis.dot11, basis.invDenom);
+        }
+        faces.pad();
+
+        // walls
+        bounds.clear();
+        for (const auto& corners : quadCorners) {
+            AABB box;
+            for (const auto& corner : corners) box.expand(corner);
+            bounds.push_back(box);
+        }
+        quadTree.build(bounds);
+        reorder(quadCorners, quadTree.getIndices());
+        reorder(quadBasis, quadTree.getIndices());
+    }
+
+    bool CollisionMesh::collideTriangle(Sphere& sphere, int i) {
+        // plane distance straight from the flat arrays, most triangles stop here
+        if (abs(triNormal[i].dot(sphere.getWorldPosition() - triA[i])) > sphere.getRadius())
+            return false;
+
+        Vec3 corners[3] = {triA[i], triB[i], triC[i]};
+        TriangleBasis basis;
+        basis.v0 = Vec3(faces.e0x[i], faces.e0y[i], faces.e0z[i]);
+        basis.v1 = Vec3(faces.e1x[i], faces.e1y[i], faces.e1z[i]);
+        basis.dot00 = faces.dot00[i];
+        basis.dot01 = faces.dot01[i];
+        basis.dot11 = faces.dot11[i];
+        basis.invDenom = faces.invDenom[i];
+        const Material& material = materials[triMaterial[i]];
+        return Triangle::collideWorld(sphere, corners, triNormal[i], basis, material.surface, material.faceCollisionOnly);
+    }
+
+    bool CollisionMesh::collideQuad(Sphere& sphere, int i) {
+        return Wall::collideWorld(sphere, quadCorners[i].data(), quadBasis[i]);
+    }
+
+    bool CollisionMesh::collideTriangles(Sphere& sphere, int first, int count) {
+        bool collided = false;
+        int end = first + count;
+        int i = first;
+        while (i < end) {
+            Vec3 center = sphere.getWorldPosition();
+            TriangleHits hits;
+            kernel(faces, i, center.x, center.y, center.z, sphere.getRadius(), hits);
+
+            int lanes = std::min(4, end - i);
+            int next = i + lanes;
+            for (int lane = 0; lane < lanes; lane++) {
+                if (!(hits.planeMask & (1u << lane))) continue;
+                int index = i + lane;
+                if (materials[triMaterial[index]].faceCollisionOnly && !(hits.faceMask & (1u << lane))) continue;
+
+                // a possible contact, the scalar test resolves it
+                // it may move the sphere, so the rest of the batch is tested again
+                if (collideTriangle(sphere, index)) collided = true;
+                next = index + 1;
+                break;
+            }
+            i = next;
+        }
+        return collided;
+    }
+
+    bool CollisionMesh::collide(Sphere& sphere, const AABB& box) {
+        bool collided = false;
+
+        triangleTree.queryLeaves(box, [&](int first, int count) {
+            if (collideTriangles(sphere, first, count)) collided = true;
+        });
+        quadTree.queryLeaves(box, [&](int first, int count) {
+            for (int i = first; i < first + count; i++) {
+                if (collideQuad(sphere, i)) collided = true;
+            }
+        });
+
+        return collided;
+    }
+
+}
+
+namespace golf {
+
+    bool CollisionMesh::sweep(const Vec3& start, const Vec3& motion, double radius, double& t) {
+        bool found = false;
+        double hit;
+        AABB box = sweptBounds(start, motion, radius).inflated(0.01);
+
+        triangleTree.queryLeaves(box, [&](int first, int count) {
+            for (int i = first; i < first + count; i++) {
+                bool faceOnly = materials[triMaterial[i]].faceCollisionOnly;
+                if (sweepSphereTriangle(start, motion, radius, triA[i], triB[i], triC[i], hit, faceOnly) && (!found || hit < t)) {
+                    t = hit;
+                    found = true;
+                }
+            }
+        });
+        quadTree.queryLeaves(box, [&](int first, int count) {
+            for (int i = first; i < first + count; i++) {
+                if (sweepSphereQuad(start, motion, radius, quadCorners[i].data(), hit) && (!found || hit < t)) {
+                    t = hit;
+                    found = true;
+                }
+            }
+        });
+
+        return found;
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef COLLISIONMESH_HPP
+#define COLLISIONMESH_HPP
+
+#include <vector>
+#include "simulation.hpp"
+#include "bvh.hpp"
+#include "trianglekernel.hpp"
+
+namespace golf
+{
+
+    // the static triangles and walls of a course, baked into flat arrays
+    // one array per attribute, indexed by primitive, world space data is precomputed
+    // so a collision test reads contiguous memory and never allocates
+    class CollisionMesh
+    {
+
+    public:
+        struct Material
+        {
+            Surface surface;
+            bool faceCollisionOnly = false;
+        };
+
+    private:
+        // triangles
+        // first corner, normal and barycentric basis are packed for the batch face test
+        PackedTriangles faces;
+        // the other corners are only needed for corner and edge tests
+        std::vector<Vec3> triA, triB, triC;
+        std::vector<Vec3> triNormal;
+        std::vector<unsigned short> triMaterial;
+
+        // walls
+        std::vector<std::array<Vec3, 4>> quadCorners;
+        std::vector<WallBasis> quadBasis;
+
+        std::vector<Material> materials;
+
+        // built over the primitives above, the arrays are reordered so every leaf is one contiguous run
+        BVH triangleTree;
+        BVH quadTree;
+
+        TriangleKernel kernel;
+
+        unsigned short addMaterial(const Material &material);
+        template <typename T>
+        static void reorder(std::vector<T> &values, const std::vector<int> &order);
+        bool collideTriangles(Sphere &sphere, int first, int count);
+
+    public:
+        CollisionMesh() : kernel(getTriangleKernel()) {}
+
+        void clear();
+        void addTriangle(const Vec3 &a, const Vec3 &b, const Vec3 &c, const Vec3 &normal, const Surface &surface, bool faceCollisionOnly);
+        void addQuad(const std::array<Vec3, 4> &corners, const Vec3 &normal);
+        // precomputes the per triangle data and builds the trees, call after the last add
+        void build();
+        // the batch face test is on by default, the scalar path is kept for comparisons
+        void setKernel(TriangleKernel kernel) { this->kernel = kernel; }
+
+        size_t getTriangleCount() const { return triA.size(); }
+        size_t getQuadCount() const { return quadBasis.size(); }
+        // tests the triangles and walls whose bounds overlap the query box, see Course::collide
+        bool collide(Sphere &sphere, const AABB &box);
+        // earliest impact on any triangle or wall, see sweep.hpp
+        bool sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t);
+        bool collideTriangle(Sphere &sphere, int index);
+        bool collideQuad(Sphere &sphere, int index);
+    };
+
+}
+
+#endif // COLLISIONMESH_HPP
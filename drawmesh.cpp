@@ -0,0 +1,31 @@
+#include "drawmesh.hpp"
+
+namespace golf {
+
+    void DrawMesh::pushVertex(const Vec3& position, const QVector3D& normal) {
+        QVector3D p = transform.map(QVector3D(position.x, position.y, position.z));
+        vertices.push_back({
+            {p.x(), p.y(), p.z()},
+            {normal.x(), normal.y(), normal.z()},
+            {static_cast<float>(color.x), static_cast<float>(color.y), static_cast<float>(color.z)}
+        });
+    }
+
+    void DrawMesh::addVertex(const Vec3& position, const Vec3& normal) {
+        pushVertex(position, transform.mapVector(QVector3D(normal.x, normal.y, normal.z)));
+    }
+
+    void DrawMesh::addTriangle(const Vec3& a, const Vec3& b, const Vec3& c, const Vec3& normal) {
+        // the transforms only translate and rotate, so normals only need the rotation
+        QVector3D n = transform.mapVector(QVector3D(normal.x, normal.y, normal.z));
+        pushVertex(a, n);
+        pushVertex(b, n);
+        pushVertex(c, n);
+    }
+
+    void DrawMesh::addQuad(const std::array<Vec3, 4>& corners, const Vec3& normal) {
+        addTriangle(corners[0], corners[1], corners[2], normal);
+        addTriangle(corners[0], corners[2], corners[3], normal);
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef DRAWMESH_HPP
+#define DRAWMESH_HPP
+
+#include <array>
+#include <vector>
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    // the visible geometry of a course, baked into one interleaved vertex array
+    // plain cpu side data, the gui uploads it into a vertex buffer and draws it as GL_TRIANGLES
+    class DrawMesh
+    {
+
+    public:
+        struct Vertex
+        {
+            float position[3];
+            float normal[3];
+            float color[3];
+        };
+
+        // a run of vertices drawn with one call
+        struct Range
+        {
+            int first = 0;
+            int count = 0;
+        };
+
+    private:
+        std::vector<Vertex> vertices;
+        // transform the next vertices are baked with
+        QMatrix4x4 transform;
+        Vec3 color = Vec3(1, 0, 0);
+
+        void pushVertex(const Vec3 &position, const QVector3D &normal);
+
+    public:
+        void clear() { vertices.clear(); }
+        void setTransform(const QMatrix4x4 &transform) { this->transform = transform; }
+        const QMatrix4x4 &getTransform() const { return transform; }
+        void setColor(const Vec3 &color) { this->color = color; }
+
+        // a single vertex with its own normal, three in a row form a triangle
+        void addVertex(const Vec3 &position, const Vec3 &normal);
+        // corners in the local space of the current transform
+        void addTriangle(const Vec3 &a, const Vec3 &b, const Vec3 &c, const Vec3 &normal);
+        // split into the triangles 0 1 2 and 0 2 3, like GL_QUADS does
+        void addQuad(const std::array<Vec3, 4> &corners, const Vec3 &normal);
+
+        // start a range at the current end and close it again
+        Range beginRange() const { return {static_cast<int>(vertices.size()), 0}; }
+        void endRange(Range &range) const { range.count = static_cast<int>(vertices.size()) - range.first; }
+
+        const std::vector<Vertex> &getVertices() const { return vertices; }
+        bool isEmpty() const { return vertices.empty(); }
+    };
+
+}
+
+#endif // DRAWMESH_HPP
@@ -0,0 +1,94 @@
+#include "meshrenderer.h"
+#include "profiler.hpp"
+#include <cstddef>
+
+void MeshRenderer::initialize()
+{
+    initializeOpenGLFunctions();
+    buffer.create();
+    buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    ballBuffer.create();
+    ballBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+}
+
+void MeshRenderer::cleanup()
+{
+    buffer.destroy();
+    ballBuffer.destroy();
+    uploadedCourse.reset();
+}
+
+void MeshRenderer::upload(QOpenGLBuffer &target, const golf::DrawMesh &mesh)
+{
+    const auto &vertices = mesh.getVertices();
+    target.bind();
+    target.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(golf::DrawMesh::Vertex)));
+    target.release();
+}
+
+void MeshRenderer::drawRange(QOpenGLBuffer &source, const golf::DrawMesh::Range &range)
+{
+    if (range.count == 0)
+        return;
+
+    constexpr GLsizei stride = sizeof(golf::DrawMesh::Vertex);
+    source.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    // offsets into the bound buffer
+    glVertexPointer(3, GL_FLOAT, stride, reinterpret_cast<const void *>(offsetof(golf::DrawMesh::Vertex, position)));
+    glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const void *>(offsetof(golf::DrawMesh::Vertex, normal)));
+    glColorPointer(3, GL_FLOAT, stride, reinterpret_cast<const void *>(offsetof(golf::DrawMesh::Vertex, color)));
+
+    glDrawArrays(GL_TRIANGLES, range.first, range.count);
+
+    // immediate mode objects are drawn in between, leave no arrays enabled
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    source.release();
+}
+
+void MeshRenderer::drawBalls(const golf::RenderState &state)
+{
+    PROFILE_SCOPE("MeshRenderer::drawBalls");
+    // one call for all balls, whatever their number
+    state.bakeBalls(balls);
+    upload(ballBuffer, balls);
+    drawRange(ballBuffer, {0, static_cast<int>(balls.getVertices().size())});
+
+    if (!SimObject::showAxis)
+        return;
+    for (golf::Golfball ball : state.balls)
+    {
+        Vec3 center = ball.getInterpolatedPosition(state.alpha);
+        glPushMatrix();
+        glTranslatef(center.x, center.y, center.z);
+        ball.drawAxes();
+        glPopMatrix();
+    }
+}
+
+void MeshRenderer::draw(const golf::RenderState &state)
+{
+    if (state.course == nullptr)
+        return;
+
+    if (state.course != uploadedCourse)
+    {
+        PROFILE_SCOPE("MeshRenderer::upload");
+        upload(buffer, state.course->getDrawMesh());
+        uploadedCourse = state.course;
+    }
+
+    {
+        PROFILE_SCOPE("MeshRenderer::drawCourse");
+        state.course->draw(state, [this](const golf::DrawMesh::Range &range)
+                           { drawRange(buffer, range); });
+    }
+    drawBalls(state);
+
+    if (state.showArrow)
+        golf::Controller::drawArrow(state.arrowStart, state.arrowEnd);
+}
@@ -0,0 +1,37 @@
+#ifndef MESHRENDERER_H
+#define MESHRENDERER_H
+
+#include "renderstate.hpp"
+
+#include <QOpenGLFunctions>
+#include <QOpenGLBuffer>
+#include <memory>
+
+// draws render snapshots with the baked draw mesh of the course in a vertex buffer
+// the buffer is uploaded again whenever the snapshot shows a different course
+// must only be used on the gui thread with the widget context current
+class MeshRenderer : protected QOpenGLFunctions
+{
+
+public:
+    MeshRenderer() : buffer(QOpenGLBuffer::VertexBuffer), ballBuffer(QOpenGLBuffer::VertexBuffer) {}
+
+    void initialize();
+    // frees the buffer, the context has to be current
+    void cleanup();
+    void draw(const golf::RenderState &state);
+
+private:
+    QOpenGLBuffer buffer;
+    // course whose mesh is in the buffer, kept alive so its address can not be reused
+    std::shared_ptr<golf::Course> uploadedCourse;
+    // all balls of a frame, rebuilt from the cached sphere mesh and streamed every frame
+    QOpenGLBuffer ballBuffer;
+    golf::DrawMesh balls;
+
+    void upload(QOpenGLBuffer &target, const golf::DrawMesh &mesh);
+    void drawRange(QOpenGLBuffer &source, const golf::DrawMesh::Range &range);
+    void drawBalls(const golf::RenderState &state);
+};
+
+#endif // MESHRENDERER_H
@@ -1,7 +1,12 @@
 
 #include "minigolf.hpp"
 #include <iostream>
+#include <algorithm>
 #include <obstacles.hpp>
+#include "terrain.hpp"
+#include "sweep.hpp"
+#include "renderstate.hpp"
+#include "profiler.hpp"
 
 namespace golf {
 
@@ -31,7 +36,9 @@ namespace golf {
 
     void Player::reset(Vec3 position) {
         ball.setPosition(position);
+        ball.storePreviousPosition();
         ball.setVelocity(Vec3(0));
+        ball.wake();
         strokes = 0;
         finishedHole = false;
         startedHole = false;
@@ -50,18 +57,76 @@ namespace golf {
         }
     }
 
-    void Course::draw() {
-        SimObject::draw();
+    void Course::draw(const RenderState& state, const std::function<void(const DrawMesh::Range&)>& drawRange) {
+        glPushMatrix();
+        glTranslatef(position.x, position.y, position.z);
+        glMultMatrixf(getRotation().data());
+
+        drawRange(staticRange);
+        drawImmediate(-1);
+
+        for (size_t i = 0; i < dynamicRanges.size() && i < state.dynamicPositions.size(); i++) {
+            Vec3 offset = state.dynamicPositions[i] - dynamicBakePositions[i];
+            glPushMatrix();
+            glTranslatef(offset.x, offset.y, offset.z);
+            drawRange(dynamicRanges[i]);
+            drawImmediate(i);
+            glPopMatrix();
+        }
+
+        glPopMatrix();
 
         drawHole();
+    }
 
-        for (Player& player : game.getPlayers()) {
-            // draw ball
-            Golfball& ball = player.getBall();
-            //std::cout << ball.getPosition().x << ", " << ball.getPosition().y << ", " << ball.getPosition().z << std::endl;
-            if (!player.isInGame()) continue;
-            player.getBall().draw();
-            
+    void Course::drawImmediate(int dynamicIndex) {
+        for (ImmediateDrawable& drawable : immediateDrawables) {
+            if (drawable.dynamicIndex != dynamicIndex) continue;
+            glPushMatrix();
+            glMultMatrixf(drawable.parentTransform.data());
+            drawable.object->draw();
+            glPopMatrix();
+        }
+    }
+
+    void Course::buildDrawMesh() {
+        if (drawMeshBuilt) return;
+        drawMesh.clear();
+        dynamicRanges.clear();
+        dynamicBakePositions.clear();
+        immediateDrawables.clear();
+
+        // in the space of the course, its own transform is applied when drawing
+        staticRange = drawMesh.beginRange();
+        for (SimObject* child : children) {
+            if(std::find(dynamicChildren.begin(), dynamicChildren.end(), child) != dynamicChildren.end()) continue;
+            collectDrawables(child, QMatrix4x4(), -1);
+        }
+        drawMesh.endRange(staticRange);
+
+        for (size_t i = 0; i < dynamicChildren.size(); i++) {
+            DrawMesh::Range range = drawMesh.beginRange();
+            dynamicBakePositions.push_back(dynamicChildren[i]->getPosition());
+            collectDrawables(dynamicChildren[i], QMatrix4x4(), i);
+            drawMesh.endRange(range);
+            dynamicRanges.push_back(range);
+        }
+        drawMeshBuilt = true;
+    }
+
+    void Course::collectDrawables(SimObject* object, const QMatrix4x4& parentTransform, int dynamicIndex) {
+        QMatrix4x4 transform = parentTransform;
+        transform.translate(object->getPosition().x, object->getPosition().y, object->getPosition().z);
+        transform *= object->getRotation();
+
+        drawMesh.setTransform(transform);
+        if(!object->bakeDrawing(drawMesh)) {
+            // draw() takes care of the children too
+            immediateDrawables.push_back({object, parentTransform, dynamicIndex});
+            return;
+        }
+        for (SimObject* child : object->getChildren()) {
+            collectDrawables(child, transform, dynamicIndex);
         }
     }
 
@@ -88,10 +153,24 @@ namespace golf {
     }
 
     bool Course::collide(Sphere& sphere) {
-        
-        // collide with obstacles
-        bool collided = false;
-        for (SimObject* child : children) {
+        PROFILE_SCOPE("Course::collide");
+
+        if(!broadphaseBuilt) buildBroadphase();
+
+        // only test the static colliders whose bounds touch the path of the sphere in this step
+        // small margin for the edge tolerance in Triangle::collide
+        const Vec3& start = sphere.getPreviousPosition();
+        AABB box = sweptBounds(start, sphere.getWorldPosition() - start, sphere.getRadius()).inflated(0.01);
+
+        bool collided = mesh.collide(sphere, box);
+        broadphase.query(box, [&](int index) {
+            if(staticColliders[index]->collide(sphere)) {
+                collided = true;
+            }
+        });
+
+        // collide with moving obstacles
+        for (SimObject* child : dynamicChildren) {
             if(child->collide(sphere)) {
                 collided = true;
             }
@@ -99,18 +178,119 @@ namespace golf {
         return collided;
     }
 
+    bool Course::sweep(const Vec3& start, const Vec3& motion, double radius, double& t) {
+        PROFILE_SCOPE("Course::sweep");
+
+        if(!broadphaseBuilt) buildBroadphase();
+
+        bool found = mesh.sweep(start, motion, radius, t);
+        double hit;
+
+        broadphase.query(sweptBounds(start, motion, radius).inflated(0.01), [&](int index) {
+            if(staticColliders[index]->sweep(start, motion, radius, hit) && (!found || hit < t)) {
+                t = hit;
+                found = true;
+            }
+        });
+
+        for (SimObject* child : dynamicChildren) {
+            if(child->sweep(start, motion, radius, hit) && (!found || hit < t)) {
+                t = hit;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void Course::getDynamicBounds(std::vector<AABB>& bounds) {
+        bounds.resize(dynamicChildren.size());
+        for (size_t i = 0; i < dynamicChildren.size(); i++) {
+            bounds[i] = AABB();
+            expandBounds(dynamicChildren[i], bounds[i]);
+        }
+    }
+
+    void Course::expandBounds(SimObject* object, AABB& bounds) {
+        AABB box;
+        if(object->getWorldBounds(box)) {
+            bounds.expand(box);
+            return;
+        }
+        for (SimObject* child : object->getChildren()) {
+            expandBounds(child, bounds);
+        }
+    }
+
+    void Course::addDynamicChild(SimObject* child) {
+        addChild(child);
+        dynamicChildren.push_back(child);
+        broadphaseBuilt = false;
+    }
+
+    void Course::buildBroadphase() {
+        mesh.clear();
+        staticColliders.clear();
+        std::vector<AABB> bounds;
+        // baked objects are only released once the draw mesh has them too
+        collectColliders(children, bounds, drawMeshBuilt);
+        mesh.build();
+        broadphase.build(bounds);
+        broadphaseBuilt = true;
+    }
+
+    void Course::collectColliders(std::vector<SimObject*>& objects, std::vector<AABB>& bounds, bool drawnFromMesh) {
+        size_t kept = 0;
+        for (SimObject* object : objects) {
+            objects[kept++] = object;
+            if(std::find(dynamicChildren.begin(), dynamicChildren.end(), object) != dynamicChildren.end()) continue;
+
+            // children of an object that draws itself are drawn through it
+            bool drawn = drawnFromMesh && !isImmediateDrawable(object);
+
+            // triangles and walls go into the flat mesh
+            if(object->bake(mesh)) {
+                if(drawn) {
+                    kept--;
+                    delete object;
+                }
+                continue;
+            }
+
+            // other objects with their own geometry are leaves, everything else is a container
+            AABB box;
+            if(object->getWorldBounds(box)) {
+                staticColliders.push_back(object);
+                bounds.push_back(box);
+                continue;
+            }
+            collectColliders(object->getChildren(), bounds, drawn);
+        }
+        objects.resize(kept);
+    }
+
+    bool Course::isImmediateDrawable(SimObject* object) {
+        for (const ImmediateDrawable& drawable : immediateDrawables) {
+            if(drawable.object == object) return true;
+        }
+        return false;
+    }
+
     void Course::tick(unsigned long long time) {
 
         checkHole();
 
     }
 
+    bool Course::isInHole(Sphere& ball) {
+        return ball.getPosition().getDistance(holePosition) < holeRadius + ball.getRadius();
+    }
+
     void Course::checkHole() {
         // check if any player is in the hole
 
         for (Player& player : game.getPlayers()) {
             if(player.hasFinishedHole()) continue;
-            if (player.getBall().getPosition().getDistance(holePosition) < holeRadius + player.getBall().getRadius()) {
+            if (isInHole(player.getBall())) {
                 // player is in hole
                 std::cout << getScoreTerm(player.getStrokes(), par) << "!" << std::endl;
                 std::cout << player.getName() << " is in the hole!" << std::endl;
@@ -256,10 +436,7 @@ namespace golf {
             return height;
         };
 
-        std::vector<Triangle*> triangles = createFloor(-5, 5, 0.5, minHeightFunction);
-        for (Triangle* triangle : triangles) {
-            addChild(triangle);
-        }
+        addChild(new HeightfieldTerrain(-5, 5, 0.5, minHeightFunction));
 
         std::vector<double> xz;
         for(double i = 0; i < 2*PI; i += PI/16) {
@@ -296,10 +473,7 @@ namespace golf {
 
         
 
-        std::vector<Triangle*> triangles = createFloor(-5, 5, 0.5, heightFunction);
-        for (Triangle* triangle : triangles) {
-            addChild(triangle);
-        }
+        addChild(new HeightfieldTerrain(-5, 5, 0.5, heightFunction));
         std::vector<double> xz = {-4, -2, -4, 0, 1, 0, 1, 0, 1, 4, 3, 4, 3, 0, 1, -2};
 
         auto walls = buildWallsOnGround(xz, 1, heightFunction);
@@ -309,7 +483,7 @@ namespace golf {
 
         // add obstacles
         obstacle = new Pillar(Vec3(1, 0, 2), 0.5, 4);
-        addChild(obstacle);
+        addDynamicChild(obstacle);
 
         
     }
@@ -321,30 +495,40 @@ namespace golf {
         this->obstacle->setPosition(p);
     }
 
-    void Controller::draw() {
-        if(game.getShotState() != ShotState::AIMING) return;
+    bool Controller::getArrow(Vec3& start, Vec3& end) {
+        if(game.getShotState() != ShotState::AIMING) return false;
 
-        // draw arrow to indicate shot direction and power
+        // arrow to indicate shot direction and power
 
-        if(game.getCurrentPlayer() < 0) return;
+        if(game.getCurrentPlayer() < 0) return false;
 
         Player& player = game.getPlayers()[game.getCurrentPlayer()];
-        if(!player.isInGame()) return;
-        if(!mouseHeld) return;
-
+        if(!player.isInGame()) return false;
 
         Vec3 ballPosition = player.getBall().getPosition();
+        if(!mouseHeld) {
+            if(!hasHint) return false;
+            start = ballPosition;
+            end = ballPosition + hint;
+            return true;
+        }
+
         Vec3 direction = mouseLast - ballPosition;
         if(direction.length() > maxLength) {
             direction = direction.normalized() * maxLength;
         }
-        Vec3 arrowEnd = ballPosition + direction;
+        start = ballPosition;
+        end = ballPosition + direction;
+        return true;
+    }
+
+    void Controller::drawArrow(const Vec3& start, const Vec3& end) {
         // draw arrow
         glColor3f(0.2, 0.1, 1);
         glLineWidth(5);
         glBegin(GL_LINES);
-        glVertex3f(ballPosition.x, ballPosition.y, ballPosition.z);
-        glVertex3f(arrowEnd.x, arrowEnd.y, arrowEnd.z);
+        glVertex3f(start.x, start.y, start.z);
+        glVertex3f(end.x, end.y, end.z);
         glEnd();
 
     }
@@ -379,6 +563,14 @@ namespace golf {
 
         Player& player = game.getPlayers()[game.getCurrentPlayer()];
 
+        if(this->hasQueuedShot) {
+            game.shootBall(queuedShot);
+            this->hasQueuedShot = false;
+            this->mouseReleased = false;
+            this->mouseHeld = false;
+            return;
+        }
+
         if(this->mouseReleased) {
             // shoot ball
             Vec3 ballPosition = player.getBall().getPosition();
@@ -417,19 +609,42 @@ namespace golf {
 
     }
 
+    void Game::prepareCollision() {
+        if (course == nullptr)
+            return;
+        if (!course->isBroadphaseBuilt())
+            course->buildBroadphase();
+        // world transforms are computed on read, so they have to be current before threads read them
+        course->updateWorldTransforms();
+    }
+
     bool Game::collide(Sphere& sphere) {
         return this->course->collide(sphere);
     }
 
-    void Game::draw() {
+    bool Game::sweep(const Vec3& start, const Vec3& motion, double radius, double& t) {
+        return this->course->sweep(start, motion, radius, t);
+    }
 
-        // draw course
-        if (course != nullptr)
-            course->draw();
+    void Game::snapshot(RenderState& state) {
+        PROFILE_SCOPE("Game::snapshot");
+        state.course = course;
 
-        // draw controller
-        controller.draw();
+        // the vectors keep their capacity between frames
+        state.balls.clear();
+        for (Player& player : players) {
+            if (!player.isInGame()) continue;
+            state.balls.push_back(player.getBall());
+        }
+
+        state.dynamicPositions.clear();
+        if (course != nullptr) {
+            for (SimObject* child : course->getDynamicChildren()) {
+                state.dynamicPositions.push_back(child->getPosition());
+            }
+        }
 
+        state.showArrow = controller.getArrow(state.arrowStart, state.arrowEnd);
     }
 
     void Game::startGame() {
@@ -444,13 +659,13 @@ namespace golf {
         switch (currentLevel)
         {
         case 0:
-            setLevel(new CourseA8(*this));
+            setLevel(buildLevel<CourseA8>(*this));
             break;
         case 1:
-            setLevel(new Course2(*this));
+            setLevel(buildLevel<Course2>(*this));
             break;
         case 2:
-            setLevel(new Course4(*this));
+            setLevel(buildLevel<Course4>(*this));
             break;
         default:
             setLevel(nullptr);
@@ -523,14 +738,27 @@ namespace golf {
 
         Player& player = players[currentPlayer];
         shotStart = player.getBall().getPosition();
-        lastBallPosition = shotStart;
-        noMovementCounter = 0;
         shotState = ShotState::MOVING;
         player.getBall().setVelocity(velocity);
+        player.getBall().wake();
         player.addStroke();
+        controller.clearHint();
+
+        if(shotListener)
+            shotListener(velocity);
 
     }
 
+    void Game::ballCameToRest() {
+        if(shotState != ShotState::MOVING) return;
+
+        // the shot ball may have knocked others into motion
+        for (Player& player : players) {
+            if(player.isInGame() && !player.getBall().isSleeping()) return;
+        }
+        shotState = ShotState::READY;
+    }
+
     void Game::getNextPlayer() {
         // find the next turn player
 
@@ -567,8 +795,14 @@ namespace golf {
     }
 
     void Game::setLevel(Course* course) {
-        if(this->course != nullptr) delete(this->course);
-        this->course = course;
+        setLevel(std::shared_ptr<Course>(course));
+    }
+
+    void Game::setLevel(std::shared_ptr<Course> course) {
+        // the old course is deleted once no snapshot uses it anymore
+        this->course = std::move(course);
+        if (this->course != nullptr)
+            this->course->buildDrawMesh();
         shotState = ShotState::READY;
     }
 
@@ -599,6 +833,7 @@ namespace golf {
                 // out of bounds
                 players[currentPlayer].getBall().setPosition(course->getStartPosition());
                 players[currentPlayer].getBall().setVelocity(Vec3(0));
+                players[currentPlayer].getBall().wake();
                 shotState = ShotState::AIMING;
                 // give penalty
                 players[currentPlayer].addStroke();
@@ -627,17 +862,7 @@ namespace golf {
                 shotState = ShotState::READY;
                 break;
             }
-            // check if ball has stopped
-            if(lastBallPosition.getDistance(players[currentPlayer].getBall().getPosition()) < 0.01) {
-                noMovementCounter++;
-            } else {
-                noMovementCounter = 0;
-            }
-            if(noMovementCounter>120) {
-                shotState = ShotState::READY;
-            }
-            lastBallPosition = players[currentPlayer].getBall().getPosition();
-
+            // the shot ends in ballCameToRest
             break;
         case ShotState::FINISHED:
             startGame();
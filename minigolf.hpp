@@ -4,8 +4,13 @@
 
 #include <vector>
 #include "simulation.hpp"
+#include "bvh.hpp"
+#include "collisionmesh.hpp"
+#include "drawmesh.hpp"
+#include "arena.hpp"
 #include <string>
 #include <functional>
+#include <memory>
 
 namespace golf
 {
@@ -69,6 +74,7 @@ namespace golf
         void setStartedHole(bool startedHole) { this->startedHole = startedHole; }
     };
     class Game;
+    struct RenderState;
     // a base golf course with walls, floor, obstacles and a hole
     class Course : public SimObject
     {
@@ -78,15 +84,70 @@ namespace golf
         Vec3 startPosition;
         Game &game;
         unsigned int par = 3;
+        // children that move and can not be part of the broadphase
+        std::vector<SimObject*> dynamicChildren;
+        // static triangles and walls, baked into flat arrays
+        CollisionMesh mesh;
+        // static colliders that can not be baked, indexed by the broadphase
+        std::vector<SimObject*> staticColliders;
+        BVH broadphase;
+        bool broadphaseBuilt = false;
+
+        // objects that can not be baked into the draw mesh
+        struct ImmediateDrawable
+        {
+            SimObject *object;
+            // transform of the parent within the course
+            QMatrix4x4 parentTransform;
+            // index of the moving child it belongs to, -1 for static geometry
+            int dynamicIndex;
+        };
+
+        // visible geometry, static first, then one range per moving child
+        DrawMesh drawMesh;
+        DrawMesh::Range staticRange;
+        std::vector<DrawMesh::Range> dynamicRanges;
+        // the moving children are baked where they are and shifted to their snapshot position when drawn
+        std::vector<Vec3> dynamicBakePositions;
+        std::vector<ImmediateDrawable> immediateDrawables;
+        bool drawMeshBuilt = false;
+
+        // bakes or collects the colliders among objects and their children
+        // objects that went into both baked meshes are deleted and removed from objects
+        void collectColliders(std::vector<SimObject*>& objects, std::vector<AABB>& bounds, bool drawnFromMesh);
+        bool isImmediateDrawable(SimObject* object);
+        static void expandBounds(SimObject* object, AABB& bounds);
+        void collectDrawables(SimObject* object, const QMatrix4x4& parentTransform, int dynamicIndex);
+        void drawImmediate(int dynamicIndex);
 
     public:
         Course(Game &game, Vec3 holePosition, Vec3 startPosition);
-        void draw();
+        // draws the static geometry and the moving children as they are in the snapshot
+        // the baked draw mesh is drawn through drawRange, one call per range
+        // the balls are left to the caller, see RenderState::bakeBalls
+        void draw(const RenderState &state, const std::function<void(const DrawMesh::Range &)> &drawRange);
+        void addDynamicChild(SimObject* child);
+        std::vector<SimObject*> &getDynamicChildren() { return dynamicChildren; }
+        // current world bounds of every moving child, empty ones for children without colliders
+        void getDynamicBounds(std::vector<AABB>& bounds);
+        // bakes the collision mesh and builds the bvh over all other static colliders
+        // done lazily on the first collision, only once
+        // triangles and walls that are in the draw mesh as well are released from the scene graph,
+        // the baked arrays are all that is left of them
+        void buildBroadphase();
+        bool isBroadphaseBuilt() { return broadphaseBuilt; }
         const Vec3 &getHolePosition() { return holePosition; }
         double getHoleRadius() { return holeRadius; }
         const Vec3 &getStartPosition() { return startPosition; }
+        CollisionMesh &getCollisionMesh() { return mesh; }
+        // bakes the visible geometry into one vertex array, done once the course is complete
+        // later calls do nothing, the broadphase may have released objects the mesh was baked from
+        void buildDrawMesh();
+        const DrawMesh &getDrawMesh() const { return drawMesh; }
         bool collide(Sphere &sphere);
+        bool sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t);
         virtual void tick(unsigned long long time);
+        bool isInHole(Sphere &ball);
         void checkHole();
         void drawHole();
         std::vector<Triangle*> createFloor(int minXY, int maxXY, double resolution, std::function<double(double, double)> heightFunction);
@@ -133,13 +194,27 @@ namespace golf
         bool mouseHeld = false;
         Vec3 mouseLast;
         bool mouseReleased = false;
+        // suggested shot shown while the mouse is not held, see ShotSolver
+        Vec3 hint;
+        bool hasHint = false;
+        // shot taken on the next tick instead of one aimed with the mouse
+        Vec3 queuedShot;
+        bool hasQueuedShot = false;
 
     public:
         Controller(Game& game) : game(game) {}
-        void draw();
+        // longest shot the player can aim, also the strongest one
+        double getMaxLength() { return maxLength; }
+        // start and end of the shot arrow, returns false if there is none to draw
+        bool getArrow(Vec3 &start, Vec3 &end);
+        static void drawArrow(const Vec3 &start, const Vec3 &end);
         void tick(unsigned long long time);
         void holdMouse(Vec3 mousePos);
         void releaseMouse();
+        void setHint(Vec3 shot) { hint = shot; hasHint = true; }
+        void clearHint() { hasHint = false; }
+        // the shot is taken at the same point of Game::tick as a shot aimed with the mouse
+        void queueShot(Vec3 shot) { queuedShot = shot; hasQueuedShot = true; }
 
     };
 
@@ -149,14 +224,15 @@ namespace golf
 
     private:
         Controller controller;
-        Course *course = nullptr;
+        // shared with render snapshots that may still draw the previous level
+        std::shared_ptr<Course> course;
         std::vector<Player> players;
         int currentPlayer = 0;
         ShotState shotState = ShotState::READY;
-        unsigned int noMovementCounter = 0;
         Vec3 shotStart;
-        Vec3 lastBallPosition;
         unsigned int currentLevel = -1;
+        // told about every shot taken, see Replay
+        std::function<void(const Vec3 &)> shotListener;
 
     public:
         Game();
@@ -164,8 +240,13 @@ namespace golf
         std::vector<Player> &getPlayers() { return players; }
         Controller &getController() { return controller; }
         Course &getCourse() { return *course; }
-        void draw();
+        // copies everything needed to draw the current frame
+        void snapshot(RenderState &state);
+        // builds the collision data and world transforms of the course that are otherwise built on first use
+        // needed before colliding from several threads at once
+        void prepareCollision();
         bool collide(Sphere &sphere);
+        bool sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t);
         void tick(unsigned long long time);
         void checkHoleEnding();
         void startGame();
@@ -173,11 +254,31 @@ namespace golf
         void endGame();
         void getNextPlayer();
         void shootBall(Vec3 velocity);
+        // called by the physics when a ball fell asleep, the shot ends once all balls in game rest
+        void ballCameToRest();
+        void setShotListener(const std::function<void(const Vec3 &)> &listener) { shotListener = listener; }
+        // takes ownership of a course allocated on its own
         void setLevel(Course* course);
+        void setLevel(std::shared_ptr<Course> course);
         int getCurrentPlayer() { return currentPlayer; }
         ShotState getShotState() { return shotState; }
     };
 
+    // creates a course of type T with all of its objects in one arena
+    // the whole scene graph goes away in one release once the last owner lets go of the course
+    template <typename T>
+    std::shared_ptr<Course> buildLevel(Game &game)
+    {
+        std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+        T *course;
+        {
+            Arena::Scope scope(*arena);
+            course = new T(game);
+        }
+        // the destructors still run, children first, before the arena frees the memory they were in
+        return std::shared_ptr<Course>(course, [arena](Course *course) { course->~Course(); });
+    }
+
 };
 
 #endif // MINIGOLF_HPP
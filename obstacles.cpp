@@ -3,9 +3,9 @@
 
 namespace golf {
 
-    Pillar::Pillar(const Vec3 &position, double radius, double height) : SimObject(position)
+    Pillar::Pillar(const Vec3 &position, double radius, double height) : Cylinder(position, radius, height)
     {
-        // create a cylinder from triangles
+        // create a cylinder from triangles for drawing, Cylinder::collide does not look at them
         // top and bottom
         SimObject* top = new SimObject;
         SimObject* bottom = new SimObject;
@@ -7,7 +7,8 @@
 namespace golf
 {
 
-    class Pillar : public SimObject
+    // drawn as triangles, collides as a cylinder
+    class Pillar : public Cylinder
     {
 
     public:
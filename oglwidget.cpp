@@ -1,11 +1,14 @@
 #include "oglwidget.h"
+#include "profiler.hpp"
 #include <math.h>
 #include "ui_mainwindow.h"
 #include "QVector3D"
 #include <iostream>
+#include <fstream>
 #include <thread>
 #include <chrono>
 #include <stdlib.h>
+#include <algorithm>
 
 // simulation loop
 // runs in separate thread
@@ -13,86 +16,43 @@ void OGLWidget::runSim()
 {
     constexpr unsigned int fps = 60;
     constexpr double dtime = 1.0 / fps;
-    double dt = dtime;
-    constexpr double G = 6.67408e-11;
-    constexpr double planetMass = 5.972e24;
-    constexpr double planetRadius = 6.371e6;
-    constexpr int micros = dtime * 1000 * 1000;
-    constexpr auto waitTime = std::chrono::microseconds(micros);
+    // never sleep longer than a frame, paramb can stop the time flow entirely
+    constexpr auto maxWait = std::chrono::microseconds(static_cast<int>(dtime * 1000 * 1000));
     auto lastTime = std::chrono::high_resolution_clock::now();
     unsigned long long frame = 0;
 
 
+    golf::Profiler::setThreadName("simulation");
     running = true;
     while (running)
     {
-        lastTime = std::chrono::high_resolution_clock::now();
-        // parama+=0.1;
-        dt = dtime * paramb;
-        game.tick(lastTime.time_since_epoch().count());
-        // apply gravity
-        for (golf::Player& player : game.getPlayers())
-        {
-            if(!player.isInGame()) continue;
-            Sphere& sphere = player.getBall();
-            // calculate gravity for planet
-            double mass = sphere.getMass();
-            double force = G * planetMass * mass / pow((sphere.getRadius()) + planetRadius, 2);
-            // apply force
-            double vel = force * dt / mass;
-            //sphere.getVelocity().y -= vel;
-            double radGrav = gravDirection * PI / 180.0;
-            sphere.getVelocity().y -=cos(radGrav) * vel;
-            sphere.getVelocity().x +=sin(radGrav) * vel;
-
-        }
+        auto now = std::chrono::high_resolution_clock::now();
+        double elapsed = std::chrono::duration<double>(now - lastTime).count();
+        lastTime = now;
 
-        // apply velocity
-        for (golf::Player& player : game.getPlayers())
+        // paramb speeds up or slows down the flow of time, the step size stays the same
+        int steps = timestep.advance(elapsed * paramb);
+        for (int i = 0; i < steps; i++)
         {
-            if(!player.isInGame()) continue;
-            Sphere& sphere = player.getBall();
-            auto movement = sphere.getVelocity() * dt;
-            sphere.move(movement);
+            applyInput();
+
+            // game logic, gravity, movement and collisions
+            // the simulation clock only moves by whole steps, so a replay sees the same times
+            physics.advance(simStep * timestep.getStepNanoseconds(), timestep.getStep());
+            simStep++;
         }
 
-        // check collisions
-        std::vector<Sphere *> bouncedSpheres;
-        for (golf::Player& player : game.getPlayers())
+        if (steps > 0)
         {
-            if(!player.isInGame()) continue;
-            Sphere& sphere = player.getBall();
-
-            // check collision with golf objects
-            game.collide(sphere);
-
-            // check if already bounced
-            if (std::find(bouncedSpheres.begin(), bouncedSpheres.end(), &sphere) != bouncedSpheres.end())
-                continue;
-
-            for (golf::Player& player : game.getPlayers())
-            {
-                if(!player.isInGame()) continue;
-                Sphere& other = player.getBall();
-
-                // continue if same pointer
-                if (&sphere == &other)
-                    continue;
-                if (sphere.getPosition().getDistance(other.getPosition()) < sphere.getRadius() + other.getRadius())
-                {
-                    sphere.bounce(other);
-
-                    // add to bounced spheres
-                    bouncedSpheres.push_back(&sphere);
-                    bouncedSpheres.push_back(&other);
-                }
-            }
+            PROFILE_SCOPE("publish");
+            // hand the new frame to paintGL
+            golf::RenderState &state = renderStates.getWriteBuffer();
+            game.snapshot(state);
+            state.alpha = timestep.getAlpha();
+            renderStates.publish();
+            update();
         }
 
-
-
-        update();
-
         // print update every second
         /*
         if (frame % fps == 0)
@@ -101,18 +61,66 @@ void OGLWidget::runSim()
             std::cout << "\rFPS: " << fps << " Frame: " << frame << " Seconds: " << secondsFromFrames <<"             " << std::flush;
         }
         */
-        std::this_thread::sleep_until(lastTime + waitTime);
+
+        // wake up when the next step is due
+        auto wait = maxWait;
+        if (paramb > 0)
+            wait = std::min(wait, std::chrono::microseconds(static_cast<long long>(timestep.getTimeToNextStep() / paramb * 1000 * 1000)));
+        std::this_thread::sleep_until(now + wait);
         frame++;
     }
 }
 
 
 
+// passes the mouse events of the gui thread on to the controller
+// runs on the simulation thread
+void OGLWidget::applyInput()
+{
+    if (mouseInput.update())
+        game.getController().holdMouse(mouseInput.getReadBuffer());
+    if (mouseReleasePending.exchange(false))
+        game.getController().releaseMouse();
+
+    if (gravityPending.exchange(false))
+    {
+        physics.setGravityDirection(gravityInput);
+        replay.addGravity(simStep, gravityInput);
+    }
+
+    if (saveReplayPending.exchange(false))
+    {
+        replay.finish(simStep, game);
+        if (replay.save("replay.grpl"))
+            std::cout << "Saved replay of " << simStep << " steps to replay.grpl" << std::endl;
+        else
+            std::cout << "Could not save replay.grpl" << std::endl;
+    }
+
+    bool hint = hintPending.exchange(false);
+    bool botShot = botShotPending.exchange(false);
+    if ((hint || botShot) && game.getShotState() == golf::ShotState::AIMING && game.getCurrentPlayer() >= 0)
+    {
+        golf::Player &player = game.getPlayers()[game.getCurrentPlayer()];
+        golf::ShotSolver::Shot shot = solver.solve(player.getBall());
+        std::cout << (shot.holed ? "Hole in reach" : "Best shot") << ", " << shot.restPosition.getDistance(game.getCourse().getHolePosition()) << " from the hole" << std::endl;
+        if (botShot)
+            game.getController().queueShot(shot.velocity);
+        else
+            game.getController().setHint(shot.velocity);
+    }
+}
+
 // default OGLWidget functions
 
 OGLWidget::OGLWidget(QWidget *parent)
-    : QOpenGLWidget(parent)
+    : QOpenGLWidget(parent), physics(game), timestep(1.0 / 60),
+      solver(physics, golf::TaskPool::getDefault()),
+      replay(timestep.getStep(), physics.getGravityDirection())
 {
+    physics.setTaskPool(&golf::TaskPool::getDefault());
+    // shots are recorded when they are taken, that is during the step simStep
+    game.setShotListener([this](const Vec3 &velocity) { replay.addShot(simStep, velocity); });
     parama = 1;
     paramb = 1;
     paramc = 1;
@@ -129,6 +137,10 @@ void OGLWidget::startSim()
 
 OGLWidget::~OGLWidget()
 {
+    // gl resources need the context
+    makeCurrent();
+    renderer.cleanup();
+    doneCurrent();
 }
 
 void OGLWidget::setUi(Ui::MainWindow *ui)
@@ -151,6 +163,8 @@ void OGLWidget::initializeGL()
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
     glEnable(GL_COLOR_MATERIAL);
 
+    renderer.initialize();
+
     this->startSim();
 }
 
@@ -182,6 +196,7 @@ void OGLWidget::setLight(int newlight)
 
 void OGLWidget::paintGL()
 {
+    PROFILE_SCOPE("OGLWidget::paintGL");
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
@@ -213,7 +228,7 @@ void OGLWidget::paintGL()
     glPopMatrix();
 
 
-    if(OGLWidget::showAxis) {
+    if(SimObject::showAxis) {
         
         // draw 3D axes and grid
         glNormal3f(3, 1, 1);
@@ -231,7 +246,10 @@ void OGLWidget::paintGL()
         glEnd();
     }
 
-    game.draw();
+    // newest snapshot from the simulation thread
+    // balls are blended between the last two physics steps
+    renderStates.update();
+    renderer.draw(renderStates.getReadBuffer());
 
     glPushMatrix();
 
@@ -305,8 +323,6 @@ Vec3 OGLWidget::screenToWorld(int x, int y) {
 
 }
 
-bool OGLWidget::showAxis = false;
-
 void OGLWidget::resizeGL(int w, int h)
 {
     glViewport(0, 0, w, h);
@@ -335,7 +351,7 @@ void OGLWidget::mousePressEvent(QMouseEvent *event)
 void OGLWidget::mouseReleaseEvent(QMouseEvent *event) {
     // something
     //std::cout << " Release " << std::endl;
-    game.getController().releaseMouse();
+    mouseReleasePending = true;
 
 }
 
@@ -354,7 +370,8 @@ void OGLWidget::mouseMoveEvent(QMouseEvent *event)
 
     Vec3 worldPos = screenToWorld(event->x(), event->y());
     //std::cout << " X: " << worldPos.x << ", Z: " << worldPos.z << std::endl;
-    game.getController().holdMouse(worldPos);
+    mouseInput.getWriteBuffer() = worldPos;
+    mouseInput.publish();
 
  ;
 
@@ -369,6 +386,34 @@ void OGLWidget::keyPressEvent(QKeyEvent *event)
         case Qt::Key_Up:
             break;
 
+        // shot solver, runs on the simulation thread
+        case Qt::Key_H:
+            hintPending = true;
+            break;
+        case Qt::Key_B:
+            botShotPending = true;
+            break;
+
+        case Qt::Key_P:
+            saveReplayPending = true;
+            break;
+
+        // F5 starts and stops profiling, F6 writes what was recorded
+        case Qt::Key_F5:
+            golf::Profiler::setEnabled(!golf::Profiler::isEnabled());
+            if (golf::Profiler::isEnabled())
+                golf::Profiler::clear();
+            std::cout << "Profiling " << (golf::Profiler::isEnabled() ? "on" : "off") << std::endl;
+            break;
+        case Qt::Key_F6:
+        {
+            std::ofstream trace("trace.json");
+            golf::Profiler::writeChromeTrace(trace);
+            golf::Profiler::writeSummary(std::cout);
+            std::cout << "Wrote trace.json" << std::endl;
+            break;
+        }
+
         // All other will be ignored
         default:
             break;
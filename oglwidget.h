@@ -3,8 +3,17 @@
 
 #include "simulation.hpp"
 #include "minigolf.hpp"
+#include "physics.hpp"
+#include "timestep.hpp"
+#include "renderstate.hpp"
+#include "triplebuffer.hpp"
+#include "meshrenderer.h"
+#include "shotsolver.hpp"
+#include "replay.hpp"
 
+#include <QOpenGLWidget>
 #include <QMouseEvent>
+#include <atomic>
 
 namespace Ui {
 class MainWindow;
@@ -18,7 +27,6 @@ class OGLWidget : public QOpenGLWidget,
 public:
     OGLWidget(QWidget *parent = 0);
     ~OGLWidget();
-    static bool showAxis;
 
     // Used to rotate object by mouse
     void mousePressEvent(QMouseEvent *event);
@@ -36,8 +44,8 @@ public slots:
     void setUi( Ui::MainWindow *ui );
     void stopSim() { running = false; }
     void startSim();
-    void toggleAxis() { showAxis = !showAxis; }
-    void setGravity(int i) { gravDirection = i;}
+    void toggleAxis() { SimObject::showAxis = !SimObject::showAxis; }
+    void setGravity(int i) { gravityInput = i; gravityPending = true; }
 
 protected:
     void initializeGL();
@@ -46,6 +54,28 @@ protected:
     void runSim();
     bool running = false;
     golf::Game game;
+    golf::PhysicsWorld physics;
+    // physics runs at a fixed rate, independent of how often the loop gets to run
+    golf::FixedTimestep timestep;
+    // the simulation thread owns game and physics, paintGL only sees these snapshots
+    golf::TripleBuffer<golf::RenderState> renderStates;
+    MeshRenderer renderer;
+    // mouse input on its way from the gui thread to the controller on the simulation thread
+    golf::TripleBuffer<Vec3> mouseInput;
+    std::atomic<bool> mouseReleasePending{false};
+    // H shows the shot the solver would take, B takes it
+    golf::ShotSolver solver;
+    std::atomic<bool> hintPending{false};
+    std::atomic<bool> botShotPending{false};
+    // gravity changes are applied between steps so they end up in the replay
+    std::atomic<int> gravityInput{0};
+    std::atomic<bool> gravityPending{false};
+    // every shot and gravity change since the start, P saves it
+    golf::Replay replay;
+    std::atomic<bool> saveReplayPending{false};
+    // steps run since the start, the simulation clock is derived from it
+    unsigned long long simStep = 0;
+    void applyInput();
     void setSphereRadius(int idx, int value);
     Vec3 screenToWorld(int x, int y);
     QMatrix4x4 projectionMatrix;
@@ -56,7 +86,6 @@ protected:
     double parama;
     double paramb;
     double paramc;
-    int gravDirection = 0;
     int lightDirection;
     double woh = 1.0;
     Ui::MainWindow *ui;
@@ -0,0 +1,206 @@
+#include "physics.hpp"
+#include "sweep.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    double PhysicsWorld::gravityAcceleration(double radius) {
+        constexpr double G = 6.67408e-11;
+        constexpr double planetMass = 5.972e24;
+        constexpr double planetRadius = 6.371e6;
+        // force / mass, so the mass of the body cancels out
+        return G * planetMass / pow(radius + planetRadius, 2);
+    }
+
+    void PhysicsWorld::setGravityDirection(int degrees) {
+        gravityDirection = degrees;
+        for (Player& player : game.getPlayers()) {
+            player.getBall().wake();
+        }
+    }
+
+    void PhysicsWorld::applyGravity(Sphere& sphere, double dt) {
+        double vel = gravityAcceleration(sphere.getRadius()) * dt;
+        double radGrav = gravityDirection * PI / 180.0;
+        sphere.getVelocity().y -= cos(radGrav) * vel;
+        sphere.getVelocity().x += sin(radGrav) * vel;
+    }
+
+    void PhysicsWorld::integrate(Sphere& sphere, double dt) {
+        auto movement = sphere.getVelocity() * dt;
+        double radius = sphere.getRadius();
+        double remaining = 1.0;
+
+        for (int i = 0; i < maxSubsteps; i++) {
+            double length = movement.length();
+            if (length <= radius * sweepThreshold) break;
+
+            double t;
+            if (!game.sweep(sphere.getWorldPosition(), movement, radius, t)) break;
+
+            // move a bit past the contact so the discrete test sees it
+            double advance = std::min(1.0, t + 0.001 / length);
+            sphere.move(movement * advance);
+            game.collide(sphere);
+
+            // continue with the new velocity for the rest of the step
+            remaining *= 1.0 - advance;
+            movement = sphere.getVelocity() * dt * remaining;
+        }
+
+        sphere.move(movement);
+    }
+
+    void PhysicsWorld::advance(unsigned long long time, double dt) {
+        {
+            PROFILE_SCOPE("Game::tick");
+            game.tick(time);
+        }
+        step(dt);
+    }
+
+    void PhysicsWorld::step(double dt) {
+        PROFILE_SCOPE("PhysicsWorld::step");
+
+        balls.clear();
+        for (Player& player : game.getPlayers()) {
+            player.getBall().storePreviousPosition();
+            if(!player.isInGame()) continue;
+            balls.push_back(&player.getBall());
+        }
+
+        wakeNearObstacles();
+        awakeBalls.clear();
+        for (Sphere* sphere : balls) {
+            if (!sphere->isSleeping())
+                awakeBalls.push_back(sphere);
+        }
+
+        if (pool != nullptr && static_cast<int>(awakeBalls.size()) >= parallelBallCount) {
+            // lazily built collision data has to exist before several threads read it
+            game.prepareCollision();
+            pool->parallelFor(static_cast<int>(awakeBalls.size()), [&](int i) {
+                advanceBall(*awakeBalls[i], dt);
+            });
+        } else {
+            for (Sphere* sphere : awakeBalls) {
+                advanceBall(*sphere, dt);
+            }
+        }
+
+        // sleeping balls stay in the ball to ball pass, so moving balls can hit them
+        collideBalls();
+
+        for (Sphere* sphere : awakeBalls) {
+            if (sphere->isSleeping())
+                game.ballCameToRest();
+        }
+    }
+
+    void PhysicsWorld::advanceBall(Sphere& sphere, double dt) {
+        if (sphere.isSleeping()) return;
+
+        PROFILE_SCOPE("PhysicsWorld::advanceBall");
+        applyGravity(sphere, dt);
+        {
+            PROFILE_SCOPE("PhysicsWorld::integrate");
+            integrate(sphere, dt);
+        }
+
+        // check collision with golf objects
+        bool contact = game.collide(sphere);
+        updateSleep(sphere, contact);
+        sphere.applySpin();
+    }
+
+    void PhysicsWorld::updateSleep(Sphere& sphere, bool contact) {
+        // a ball that is held in place without settling, like one pressed into a corner by sideways gravity,
+        // keeps bouncing off the course and may never be slow and in contact for long enough
+        if (sphere.addStillStep(stillDistance) >= stillSteps) {
+            sphere.sleep();
+            return;
+        }
+        if (!contact || sphere.getVelocity().lengthSquared() >= sleepSpeed * sleepSpeed) {
+            sphere.clearRestingSteps();
+            return;
+        }
+        if (sphere.addRestingStep() >= sleepSteps)
+            sphere.sleep();
+    }
+
+    void PhysicsWorld::wakeNearObstacles() {
+        bool anySleeping = false;
+        for (Sphere* sphere : balls) {
+            anySleeping = anySleeping || sphere->isSleeping();
+        }
+        if (!anySleeping) return;
+
+        game.getCourse().getDynamicBounds(obstacleBounds);
+        for (Sphere* sphere : balls) {
+            if (!sphere->isSleeping()) continue;
+            Vec3 center = sphere->getWorldPosition();
+            AABB bounds(center - Vec3(sphere->getRadius()), center + Vec3(sphere->getRadius()));
+            bounds = bounds.inflated(wakeDistance);
+            for (const AABB& obstacle : obstacleBounds) {
+                if (obstacle.overlaps(bounds)) {
+                    sphere->wake();
+                    break;
+                }
+            }
+        }
+    }
+
+    void PhysicsWorld::collideBalls() {
+        PROFILE_SCOPE("PhysicsWorld::collideBalls");
+
+        // bounds over the whole step, so balls that passed through each other still pair up
+        ballBounds.resize(balls.size());
+        for (size_t i = 0; i < balls.size(); i++) {
+            Sphere& sphere = *balls[i];
+            const Vec3& start = sphere.getPreviousPosition();
+            ballBounds[i] = sweptBounds(start, sphere.getWorldPosition() - start, sphere.getRadius());
+        }
+        ballBroadphase.update(ballBounds);
+        ballBroadphase.getPairs(ballPairs);
+
+        // every touching pair bounces once, a ball in a crowd is pushed out of all of its neighbours
+        // a ball that already bounced no longer moved in a straight line, it is only tested where it is now
+        bounced.assign(balls.size(), 0);
+        for (const auto& pair : ballPairs) {
+            // two balls resting against each other stay asleep
+            if (balls[pair.first]->isSleeping() && balls[pair.second]->isSleeping()) continue;
+            bool swept = !bounced[pair.first] && !bounced[pair.second];
+            if (collideBallPair(*balls[pair.first], *balls[pair.second], swept)) {
+                bounced[pair.first] = 1;
+                bounced[pair.second] = 1;
+            }
+        }
+    }
+
+    bool PhysicsWorld::collideBallPair(Sphere& sphere, Sphere& other, bool swept) {
+        double radii = sphere.getRadius() + other.getRadius();
+        bool touching = (sphere.getWorldPosition() - other.getWorldPosition()).lengthSquared() < radii * radii;
+        if (!touching && !swept) return false;
+
+        // fast balls can pass through each other within one step
+        // rewind both to the time they touched
+        double t;
+        if (!touching) {
+            const Vec3& start = sphere.getPreviousPosition();
+            const Vec3& otherStart = other.getPreviousPosition();
+            Vec3 motion = sphere.getWorldPosition() - start;
+            Vec3 otherMotion = other.getWorldPosition() - otherStart;
+            if (!sweepSphereSphere(start, motion - otherMotion, sphere.getRadius(), otherStart, other.getRadius(), t))
+                return false;
+            sphere.moveTo(start + motion * t);
+            other.moveTo(otherStart + otherMotion * t);
+        }
+
+        sphere.bounce(other);
+        sphere.wake();
+        other.wake();
+        return true;
+    }
+
+}
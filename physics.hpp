@@ -0,0 +1,94 @@
+#ifndef PHYSICS_HPP
+#define PHYSICS_HPP
+
+#include "simulation.hpp"
+#include "minigolf.hpp"
+#include "ballbroadphase.hpp"
+#include "taskpool.hpp"
+#include <utility>
+#include <vector>
+
+namespace golf
+{
+
+    // advances the balls of a game without needing a widget or a gl context
+    // the gravity, integration and collision passes used to live in OGLWidget::runSim
+    class PhysicsWorld
+    {
+
+    private:
+        Game &game;
+        // direction of gravity in degrees, 0 is straight down
+        int gravityDirection = 0;
+        // runs the per ball work in parallel if set, see step
+        TaskPool *pool = nullptr;
+
+        // ball to ball pass, kept between steps so nothing is allocated once it has grown
+        BallBroadphase ballBroadphase;
+        std::vector<Sphere *> balls;
+        // the balls of the step that are not sleeping
+        std::vector<Sphere *> awakeBalls;
+        std::vector<AABB> obstacleBounds;
+        std::vector<AABB> ballBounds;
+        std::vector<std::pair<int, int>> ballPairs;
+        std::vector<char> bounced;
+
+    public:
+        PhysicsWorld(Game &game) : game(game) {}
+
+        Game &getGame() { return game; }
+        // wakes all balls, resting ones may not be at rest anymore
+        void setGravityDirection(int degrees);
+        int getGravityDirection() { return gravityDirection; }
+        void setTaskPool(TaskPool *pool) { this->pool = pool; }
+
+        // one tick of the game at the given simulation time followed by one step
+        // everything that advances the game goes through here, so a replay runs the exact same sequence
+        void advance(unsigned long long time, double dt);
+
+        // advance all balls that are in game by dt seconds
+        // every ball keeps its position from before the step for swept tests and interpolated drawing
+        // gravity, movement and course collisions only touch the ball itself and run in parallel on the pool,
+        // the ball to ball pass after that is serial, so the result does not depend on the pool
+        // sleeping balls are skipped, balls that fell asleep in the step are reported to Game::ballCameToRest
+        void step(double dt);
+        // the per ball part of a step, does nothing for a sleeping ball
+        void advanceBall(Sphere &sphere, double dt);
+        // puts the sphere to sleep once it was slow and in contact for sleepSteps steps in a row,
+        // or stayed within stillDistance of one point for stillSteps steps in a row
+        void updateSleep(Sphere &sphere, bool contact);
+        // wakes sleeping balls a moving obstacle came close to, they might be hit in this step
+        void wakeNearObstacles();
+        void applyGravity(Sphere &sphere, double dt);
+        // moves the sphere by its velocity
+        // fast spheres are swept against the course and stopped at the first contact
+        // so they can not tunnel through thin walls
+        void integrate(Sphere &sphere, double dt);
+        // ball pairs found by the sweep and prune broadphase, over the balls of the current step
+        void collideBalls();
+        // swept also finds balls that passed through each other since their previous positions
+        bool collideBallPair(Sphere &sphere, Sphere &other, bool swept = true);
+
+        // spheres moving less than this fraction of their radius per step are not swept
+        static constexpr double sweepThreshold = 0.5;
+        // contacts resolved per sphere and step before the rest of the motion is applied as is
+        static constexpr int maxSubsteps = 4;
+        // fewer balls than this are not worth handing to the pool
+        static constexpr int parallelBallCount = 8;
+        // a ball slower than sleepSpeed and touching the course for sleepSteps steps in a row falls asleep
+        static constexpr double sleepSpeed = 0.1;
+        static constexpr int sleepSteps = 30;
+        // fallback for balls that never settle, same two seconds as the old poll in Game::tick
+        static constexpr double stillDistance = 0.01;
+        static constexpr int stillSteps = 120;
+        // sleeping balls are woken when a moving obstacle gets this close,
+        // has to be more than an obstacle moves in one step
+        static constexpr double wakeDistance = 0.1;
+
+        // acceleration of a body on the surface of the planet
+        static double gravityAcceleration(double radius);
+    };
+
+}
+
+#endif // PHYSICS_HPP
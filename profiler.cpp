@@ -0,0 +1,196 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace golf {
+
+    struct Profiler::ThreadBuffer
+    {
+        // one event, read while its thread may be writing it
+        // sequence is the index of the event + 1 once it is complete and 0 while it is written,
+        // a copy is only kept if the sequence is the expected one before and after it
+        struct Slot
+        {
+            std::atomic<uint64_t> sequence{0};
+            std::atomic<const char*> name{nullptr};
+            std::atomic<uint64_t> start{0};
+            std::atomic<uint64_t> duration{0};
+        };
+
+        std::unique_ptr<Slot[]> slots{new Slot[capacity]};
+        // events ever written, the newest is at (head - 1) % capacity
+        std::atomic<uint64_t> head{0};
+        int id;
+        std::string name;
+    };
+
+    std::atomic<bool> Profiler::enabled{false};
+
+    namespace {
+        // buffers outlive their threads, so the events of finished threads can still be written out
+        std::mutex buffersMutex;
+        std::vector<std::unique_ptr<Profiler::ThreadBuffer>>& getBuffers() {
+            static std::vector<std::unique_ptr<Profiler::ThreadBuffer>> buffers;
+            return buffers;
+        }
+        std::atomic<uint64_t> clearTime{0};
+
+        // buffers are only made for threads that record something
+        thread_local Profiler::ThreadBuffer* currentBuffer = nullptr;
+        thread_local std::string currentName;
+
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        struct ThreadEvents
+        {
+            int id;
+            std::string name;
+            std::vector<Profiler::Event> events;
+        };
+    }
+
+    // copies of all buffers, taken without stopping the writers
+    static std::vector<ThreadEvents> collect(std::vector<std::unique_ptr<Profiler::ThreadBuffer>>& buffers) {
+        std::vector<ThreadEvents> threads;
+        uint64_t since = clearTime.load();
+        for (auto& buffer : buffers) {
+            ThreadEvents thread;
+            thread.id = buffer->id;
+            thread.name = buffer->name;
+
+            uint64_t end = buffer->head.load(std::memory_order_acquire);
+            uint64_t begin = end > Profiler::capacity ? end - Profiler::capacity : 0;
+            for (uint64_t i = begin; i < end; i++) {
+                const Profiler::ThreadBuffer::Slot& slot = buffer->slots[i % Profiler::capacity];
+                uint64_t before = slot.sequence.load(std::memory_order_acquire);
+                Profiler::Event event = {slot.name.load(std::memory_order_relaxed),
+                                         slot.start.load(std::memory_order_relaxed),
+                                         slot.duration.load(std::memory_order_relaxed)};
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // the writer lapped this entry or is writing it right now
+                if (before != i + 1 || slot.sequence.load(std::memory_order_relaxed) != i + 1) continue;
+                thread.events.push_back(event);
+            }
+
+            thread.events.erase(std::remove_if(thread.events.begin(), thread.events.end(),
+                                               [since](const Profiler::Event& e) { return e.start < since; }),
+                                thread.events.end());
+            threads.push_back(std::move(thread));
+        }
+        return threads;
+    }
+
+    void Profiler::setEnabled(bool enabled) {
+        Profiler::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    void Profiler::clear() {
+        clearTime.store(now());
+    }
+
+    uint64_t Profiler::now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    Profiler::ThreadBuffer& Profiler::threadBuffer() {
+        if (currentBuffer == nullptr) {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            auto& buffers = getBuffers();
+            buffers.emplace_back(new ThreadBuffer);
+            currentBuffer = buffers.back().get();
+            currentBuffer->id = static_cast<int>(buffers.size());
+            currentBuffer->name = currentName.empty() ? "thread " + std::to_string(currentBuffer->id) : currentName;
+        }
+        return *currentBuffer;
+    }
+
+    void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+        ThreadBuffer& buffer = threadBuffer();
+        // only this thread writes head
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        ThreadBuffer::Slot& slot = buffer.slots[head % capacity];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.duration.store(end - start, std::memory_order_relaxed);
+        slot.sequence.store(head + 1, std::memory_order_release);
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::setThreadName(const std::string& name) {
+        currentName = name;
+        if (currentBuffer != nullptr) {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            currentBuffer->name = name;
+        }
+    }
+
+    void Profiler::writeChromeTrace(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        std::vector<ThreadEvents> threads = collect(getBuffers());
+
+        out << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (const ThreadEvents& thread : threads) {
+            out << (first ? "" : ",\n")
+                << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.id
+                << ",\"args\":{\"name\":\"" << thread.name << "\"}}";
+            first = false;
+            // timestamps in microseconds
+            for (const Event& event : thread.events) {
+                out << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.id
+                    << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    void Profiler::writeSummary(std::ostream& out) {
+        // durations by name over all threads
+        std::map<std::string, std::vector<uint64_t>> durations;
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            for (const ThreadEvents& thread : collect(getBuffers())) {
+                for (const Event& event : thread.events) {
+                    durations[event.name].push_back(event.duration);
+                }
+            }
+        }
+
+        // buckets are powers of two in microseconds, the first is below 1us, the last everything from 2^14us on
+        constexpr int bucketCount = 16;
+
+        for (auto& entry : durations) {
+            std::vector<uint64_t>& values = entry.second;
+            std::sort(values.begin(), values.end());
+            uint64_t total = 0;
+            int buckets[bucketCount] = {};
+            for (uint64_t value : values) {
+                total += value;
+                int bucket = 0;
+                for (uint64_t us = value / 1000; us > 0 && bucket < bucketCount - 1; us >>= 1) bucket++;
+                buckets[bucket]++;
+            }
+            auto percentile = [&](double p) { return values[static_cast<size_t>(p * (values.size() - 1))] / 1000.0; };
+
+            out << entry.first << ": " << values.size() << " calls, "
+                << total / 1e6 << " ms total, "
+                << total / 1000.0 / values.size() << " us mean, "
+                << percentile(0.5) << " us p50, "
+                << percentile(0.99) << " us p99, "
+                << values.back() / 1000.0 << " us max\n";
+
+            int last = bucketCount - 1;
+            while (last > 0 && buckets[last] == 0) last--;
+            for (int i = 0; i <= last; i++) {
+                std::string range = i == 0 ? "<1" : i == bucketCount - 1 ? ">=" + std::to_string(1 << (i - 1)) : "<" + std::to_string(1 << i);
+                out << "    " << range << " us: " << buckets[i] << "\n";
+            }
+        }
+    }
+
+}
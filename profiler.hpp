@@ -0,0 +1,90 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace golf
+{
+
+    // records timed scopes of the hot paths, see PROFILE_SCOPE
+    // every thread writes to a ring buffer of its own, nothing is locked while recording,
+    // only the first event of a thread registers its buffer
+    // while disabled a scope costs one relaxed load, with GOLF_NO_PROFILER defined it is compiled out
+    class Profiler
+    {
+
+    public:
+        struct Event
+        {
+            // has to outlive the profiler, string literals do
+            const char *name;
+            // nanoseconds since the profiler was first used
+            uint64_t start;
+            uint64_t duration;
+        };
+
+        // events kept per thread, older ones are overwritten
+        static constexpr uint64_t capacity = 1 << 15;
+
+        static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool enabled);
+        // drops everything recorded so far
+        static void clear();
+
+        static uint64_t now();
+        static void record(const char *name, uint64_t start, uint64_t end);
+        // shown for the events of the calling thread in the trace
+        static void setThreadName(const std::string &name);
+
+        // trace event json for chrome://tracing or perfetto, one complete event per scope
+        static void writeChromeTrace(std::ostream &out);
+        // per scope name count, total, mean, percentiles and a histogram of the durations
+        static void writeSummary(std::ostream &out);
+
+        // ring buffer of one thread, defined in profiler.cpp
+        struct ThreadBuffer;
+
+    private:
+        static std::atomic<bool> enabled;
+        static ThreadBuffer &threadBuffer();
+    };
+
+    class ProfileScope
+    {
+
+    private:
+        const char *name;
+        uint64_t start = 0;
+        bool active;
+
+    public:
+        ProfileScope(const char *name) : name(name), active(Profiler::isEnabled())
+        {
+            if (active) start = Profiler::now();
+        }
+        ~ProfileScope()
+        {
+            if (active) Profiler::record(name, start, Profiler::now());
+        }
+
+        ProfileScope(const ProfileScope &) = delete;
+        ProfileScope &operator=(const ProfileScope &) = delete;
+    };
+
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// times the rest of the enclosing scope under name, a string literal
+#ifdef GOLF_NO_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_SCOPE(name) golf::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,12 @@
+#include "renderstate.hpp"
+
+namespace golf {
+
+    void RenderState::bakeBalls(DrawMesh& mesh) const {
+        mesh.clear();
+        for (Golfball ball : balls) {
+            ball.bakeInstance(mesh, ball.getInterpolatedPosition(alpha));
+        }
+    }
+
+}
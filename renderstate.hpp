@@ -0,0 +1,36 @@
+#ifndef RENDERSTATE_HPP
+#define RENDERSTATE_HPP
+
+#include <memory>
+#include <vector>
+#include "minigolf.hpp"
+
+namespace golf
+{
+
+    // everything the render thread needs to draw one frame
+    // filled by the simulation thread with Game::snapshot and handed over with a TripleBuffer,
+    // so the render thread never reads the live game
+    struct RenderState
+    {
+        // shared so a level change can not delete the course while it is drawn
+        // the static geometry never changes after construction
+        std::shared_ptr<Course> course;
+        // balls that are in game, with their position from before the last step
+        std::vector<Golfball> balls;
+        // local positions of the moving course children, in the order they were added
+        std::vector<Vec3> dynamicPositions;
+        // shot arrow of the controller
+        bool showArrow = false;
+        Vec3 arrowStart;
+        Vec3 arrowEnd;
+        // how far between the last two steps the balls are drawn
+        double alpha = 1.0;
+
+        // all balls at their interpolated position in one triangle list
+        void bakeBalls(DrawMesh &mesh) const;
+    };
+
+}
+
+#endif // RENDERSTATE_HPP
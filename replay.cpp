@@ -0,0 +1,154 @@
+#include "replay.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace golf {
+
+    namespace {
+        // raw bytes of the host, every supported target is little endian
+        template <typename T>
+        void write(std::ostream& out, const T& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool read(std::istream& in, T& value) {
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        // fnv-1a
+        template <typename T>
+        void hash(uint64_t& h, const T& value) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+            for (size_t i = 0; i < sizeof(T); i++) {
+                h ^= bytes[i];
+                h *= 0x100000001b3ULL;
+            }
+        }
+
+        void hash(uint64_t& h, const Vec3& v) {
+            hash(h, v.x);
+            hash(h, v.y);
+            hash(h, v.z);
+        }
+    }
+
+    void Replay::addShot(uint64_t step, const Vec3& velocity) {
+        events.push_back({step, EventType::SHOT, velocity, 0});
+    }
+
+    void Replay::addGravity(uint64_t step, int degrees) {
+        events.push_back({step, EventType::GRAVITY, Vec3(0), degrees});
+    }
+
+    void Replay::finish(uint64_t step, Game& game) {
+        endStep = step;
+        endHash = hashState(game);
+    }
+
+    uint64_t Replay::hashState(Game& game) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (Player& player : game.getPlayers()) {
+            hash(h, player.getBall().getWorldPosition());
+            hash(h, player.getBall().getVelocity());
+            hash(h, player.getStrokes());
+            hash(h, player.getScore());
+            hash(h, player.hasStartedHole());
+            hash(h, player.hasFinishedHole());
+        }
+        hash(h, game.getCurrentPlayer());
+        hash(h, game.getShotState());
+        return h;
+    }
+
+    bool Replay::save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+
+        out.write("GRPL", 4);
+        write(out, version);
+        write(out, step);
+        write(out, gravity);
+        write(out, endStep);
+        write(out, endHash);
+        write(out, static_cast<uint32_t>(events.size()));
+        for (const Event& event : events) {
+            write(out, event.step);
+            write(out, event.type);
+            // always double, whatever precision the build uses
+            if (event.type == EventType::SHOT) {
+                write(out, static_cast<double>(event.shot.x));
+                write(out, static_cast<double>(event.shot.y));
+                write(out, static_cast<double>(event.shot.z));
+            } else {
+                write(out, event.gravity);
+            }
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool Replay::load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+
+        char magic[4];
+        uint32_t fileVersion;
+        if (!in.read(magic, 4) || std::memcmp(magic, "GRPL", 4) != 0) return false;
+        if (!read(in, fileVersion) || fileVersion != version) return false;
+
+        Replay replay;
+        uint32_t count;
+        if (!read(in, replay.step) || !read(in, replay.gravity) || !read(in, replay.endStep) ||
+            !read(in, replay.endHash) || !read(in, count))
+            return false;
+
+        replay.events.resize(count);
+        for (Event& event : replay.events) {
+            if (!read(in, event.step) || !read(in, event.type)) return false;
+            if (event.type == EventType::SHOT) {
+                event.gravity = 0;
+                double x, y, z;
+                if (!read(in, x) || !read(in, y) || !read(in, z)) return false;
+                event.shot = Vec3(x, y, z);
+            } else if (event.type == EventType::GRAVITY) {
+                event.shot = Vec3(0);
+                if (!read(in, event.gravity)) return false;
+            } else {
+                return false;
+            }
+        }
+
+        *this = replay;
+        return true;
+    }
+
+    ReplayPlayer::ReplayPlayer(const Replay& replay, PhysicsWorld& physics)
+        : replay(replay), physics(physics), timestep(replay.getStep()) {
+        physics.setGravityDirection(replay.getGravity());
+    }
+
+    void ReplayPlayer::step() {
+        const std::vector<Replay::Event>& events = replay.getEvents();
+        while (nextEvent < events.size() && events[nextEvent].step <= currentStep) {
+            const Replay::Event& event = events[nextEvent++];
+            if (event.type == Replay::EventType::SHOT)
+                physics.getGame().getController().queueShot(event.shot);
+            else
+                physics.setGravityDirection(event.gravity);
+        }
+
+        physics.advance(currentStep * timestep.getStepNanoseconds(), timestep.getStep());
+        currentStep++;
+    }
+
+    void ReplayPlayer::runTo(uint64_t step) {
+        while (currentStep < step) {
+            this->step();
+        }
+    }
+
+    bool ReplayPlayer::matches() {
+        return Replay::hashState(physics.getGame()) == replay.getEndHash();
+    }
+
+}
@@ -0,0 +1,102 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include "physics.hpp"
+#include "timestep.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace golf
+{
+
+    // everything that went into a game from outside, by simulation step
+    // a game started fresh with the same step and gravity and fed the same events ends up bit for bit the same,
+    // as long as the build uses the same Vec3 precision, see vec3.hpp
+    // saved as "GRPL", a version, the header fields and then the events, all little endian
+    class Replay
+    {
+
+    public:
+        enum class EventType : uint8_t
+        {
+            SHOT = 0,
+            GRAVITY = 1
+        };
+
+        struct Event
+        {
+            // step the event is applied before
+            uint64_t step;
+            EventType type;
+            // velocity for a shot
+            Vec3 shot;
+            // degrees for a gravity change
+            int32_t gravity;
+        };
+
+        // bumped whenever recorded games would play out differently,
+        // 2 since balls sleep and shots end as soon as they rest, 3 since pillars collide as cylinders,
+        // 4 since balls that stay in one spot without settling fall asleep
+        static constexpr uint32_t version = 4;
+
+    private:
+        double step = 1.0 / 60;
+        int32_t gravity = 0;
+        // steps recorded and the state they ended in, see hashState
+        uint64_t endStep = 0;
+        uint64_t endHash = 0;
+        std::vector<Event> events;
+
+    public:
+        Replay() {}
+        Replay(double step, int gravity) : step(step), gravity(gravity) {}
+
+        double getStep() const { return step; }
+        int getGravity() const { return gravity; }
+        uint64_t getEndStep() const { return endStep; }
+        uint64_t getEndHash() const { return endHash; }
+        const std::vector<Event> &getEvents() const { return events; }
+
+        // events have to be added in step order
+        void addShot(uint64_t step, const Vec3 &velocity);
+        void addGravity(uint64_t step, int degrees);
+        void finish(uint64_t step, Game &game);
+
+        // return false if the file can not be written or read, or is no replay of this version
+        bool save(const std::string &path) const;
+        bool load(const std::string &path);
+
+        // hash over the state of the game that physics and ticks change
+        static uint64_t hashState(Game &game);
+    };
+
+    // plays a replay back into a freshly created game, as fast as it is stepped
+    class ReplayPlayer
+    {
+
+    private:
+        const Replay &replay;
+        PhysicsWorld &physics;
+        FixedTimestep timestep;
+        uint64_t currentStep = 0;
+        size_t nextEvent = 0;
+
+    public:
+        ReplayPlayer(const Replay &replay, PhysicsWorld &physics);
+
+        uint64_t getCurrentStep() const { return currentStep; }
+        bool isFinished() const { return currentStep >= replay.getEndStep(); }
+
+        // applies the events of the current step and advances the game by one step
+        void step();
+        // steps without waiting until the replay ends or the given step is reached
+        void runTo(uint64_t step);
+        void runToEnd() { runTo(replay.getEndStep()); }
+        // true if the game is where it was when the replay was recorded, only meaningful at the end
+        bool matches();
+    };
+
+}
+
+#endif // REPLAY_HPP
@@ -0,0 +1,140 @@
+#include "sessionhost.hpp"
+#include "minigolf.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+    using Clock = std::chrono::steady_clock;
+
+    // stands in for the remote players, answers every session that waits for input after a think time
+    // the shots are aimed at the hole with some noise, so holes take a few strokes
+    class LoopbackClient
+    {
+
+    private:
+        struct Answer
+        {
+            Clock::time_point due;
+            golf::Session *session;
+            Vec3 shot;
+        };
+
+        Clock::duration thinkTime;
+        std::mutex mutex;
+        std::condition_variable changed;
+        // due in the order they were asked for, the think time is the same for all
+        std::deque<Answer> answers;
+        std::mt19937 random;
+        bool stopping = false;
+        std::atomic<unsigned long long> shots{0};
+        std::thread thread;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping)
+            {
+                if (answers.empty())
+                {
+                    changed.wait(lock);
+                    continue;
+                }
+                if (Clock::now() < answers.front().due)
+                {
+                    changed.wait_until(lock, answers.front().due);
+                    continue;
+                }
+                Answer answer = answers.front();
+                answers.pop_front();
+                lock.unlock();
+                answer.session->submitShot(answer.shot);
+                shots++;
+                lock.lock();
+            }
+        }
+
+    public:
+        explicit LoopbackClient(Clock::duration thinkTime) : thinkTime(thinkTime), thread([this] { run(); }) {}
+
+        ~LoopbackClient()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            changed.notify_all();
+            thread.join();
+        }
+
+        // input listener of the host, runs on a worker while the session is parked
+        void awaitInput(golf::Session &session)
+        {
+            golf::Game &game = session.getGame();
+            Vec3 ball = game.getPlayers()[game.getCurrentPlayer()].getBall().getPosition();
+            Vec3 toHole = game.getCourse().getHolePosition() - ball;
+            toHole.y = 0;
+            double distance = toHole.length();
+            double maxLength = game.getController().getMaxLength();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::uniform_real_distribution<double> noise(-0.2, 0.2);
+            double angle = atan2(toHole.z, toHole.x) + noise(random);
+            double length = std::min(maxLength, distance * (1.5 + noise(random)));
+            answers.push_back({Clock::now() + thinkTime, &session, Vec3(cos(angle), 0, sin(angle)) * length});
+            changed.notify_one();
+        }
+
+        unsigned long long getShots() const { return shots.load(); }
+    };
+
+}
+
+int main(int argc, char *argv[])
+{
+    int sessionCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+    double seconds = argc > 2 ? std::atof(argv[2]) : 10;
+    int thinkMilliseconds = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    // thousands of games would report every shot and hole, the workers print nothing while cout is failed
+    std::cout.setstate(std::ios::failbit);
+
+    golf::TaskPool pool;
+    golf::SessionHost host(pool);
+    LoopbackClient client{std::chrono::milliseconds(thinkMilliseconds)};
+    host.setInputListener([&](golf::Session &session) { client.awaitInput(session); });
+
+    std::cerr << "starting " << sessionCount << " sessions on " << pool.getWorkerCount() + 1 << " threads" << std::endl;
+    for (int i = 0; i < sessionCount; i++)
+    {
+        host.createSession();
+    }
+
+    std::atomic<bool> running{true};
+    std::thread timer([&] {
+        auto end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        while (running && Clock::now() < end)
+        {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            std::cerr << "shots " << client.getShots() << std::endl;
+        }
+        running = false;
+    });
+    host.run(running);
+    timer.join();
+
+    std::cout.clear();
+    host.writeReport(std::cout);
+    std::cout << "shots " << client.getShots() << std::endl;
+    return 0;
+}
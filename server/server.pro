@@ -0,0 +1,13 @@
+# Headless host running many games at once, next to A08.pro
+# qmake && make, then ./server [sessions] [seconds] [think milliseconds]
+# the sessions are played by an in-process loopback client, the report goes to stdout
+
+TEMPLATE = app
+TARGET   = server
+CONFIG  += console release
+CONFIG  -= app_bundle
+
+# Simulation core (physics, courses, obstacles)
+include(../simcore.pri)
+
+SOURCES += main.cpp
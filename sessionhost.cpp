@@ -0,0 +1,201 @@
+#include "sessionhost.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace golf {
+
+    Session::Session(SessionHost& host, int id) : host(host), id(id), physics(game) {}
+
+    void Session::step(uint64_t tickStart) {
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            if (hasPendingGravity) {
+                physics.setGravityDirection(pendingGravity);
+                hasPendingGravity = false;
+            }
+            if (hasPendingShot) {
+                game.getController().queueShot(pendingShot);
+                hasPendingShot = false;
+            }
+        }
+
+        // same clock as the app, whole steps since the session started
+        physics.advance(currentStep * host.timestep.getStepNanoseconds(), host.timestep.getStep());
+        currentStep++;
+
+        uint64_t latency = Profiler::now() - tickStart;
+        stats.steps++;
+        stats.lastLatency = latency;
+        stats.maxLatency = std::max(stats.maxLatency, latency);
+        stats.totalLatency += latency;
+
+        parkedInStep = false;
+        if (!isWaitingForInput()) return;
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            // input that came in during the step is taken by the next one
+            if (hasPendingShot || hasPendingGravity) return;
+            state = State::PARKED;
+        }
+        parkedInStep = true;
+        stats.parks++;
+
+        if (host.inputListener)
+            host.inputListener(*this);
+    }
+
+    bool Session::isWaitingForInput() {
+        if (game.getShotState() != ShotState::AIMING) return false;
+        if (game.getCurrentPlayer() < 0) return false;
+        // the next tick hands the turn on
+        if (game.getPlayers()[game.getCurrentPlayer()].hasFinishedHole()) return false;
+
+        for (Player& player : game.getPlayers()) {
+            if (player.isInGame() && !player.getBall().isSleeping()) return false;
+        }
+        return true;
+    }
+
+    bool Session::isParked() {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        return state == State::PARKED;
+    }
+
+    void Session::submitShot(const Vec3& velocity) {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        pendingShot = velocity;
+        hasPendingShot = true;
+        wakeLocked();
+    }
+
+    void Session::submitGravity(int degrees) {
+        std::lock_guard<std::mutex> lock(inputMutex);
+        pendingGravity = degrees;
+        hasPendingGravity = true;
+        wakeLocked();
+    }
+
+    void Session::wakeLocked() {
+        if (state != State::PARKED) return;
+        state = State::WOKEN;
+        host.wake(*this);
+    }
+
+    SessionHost::SessionHost(TaskPool& pool, double step) : pool(pool), timestep(step) {}
+
+    Session& SessionHost::createSession() {
+        sessions.emplace_back(new Session(*this, nextId++));
+        Session& session = *sessions.back();
+        active.push_back(&session);
+        return session;
+    }
+
+    void SessionHost::removeSession(Session& session) {
+        active.erase(std::remove(active.begin(), active.end(), &session), active.end());
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            woken.erase(std::remove(woken.begin(), woken.end(), &session), woken.end());
+        }
+        sessions.erase(std::remove_if(sessions.begin(), sessions.end(),
+                                      [&](const std::unique_ptr<Session>& s) { return s.get() == &session; }),
+                       sessions.end());
+    }
+
+    Session* SessionHost::findSession(int id) {
+        // ids are handed out in order and sessions are only ever appended
+        auto it = std::lower_bound(sessions.begin(), sessions.end(), id,
+                                   [](const std::unique_ptr<Session>& s, int id) { return s->getId() < id; });
+        if (it == sessions.end() || (*it)->getId() != id) return nullptr;
+        return it->get();
+    }
+
+    void SessionHost::wake(Session& session) {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        woken.push_back(&session);
+    }
+
+    void SessionHost::tick() {
+        PROFILE_SCOPE("SessionHost::tick");
+
+        std::vector<Session*> incoming;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            std::swap(incoming, woken);
+        }
+        // taken outside of wakeMutex, submitting locks the session first and the host second
+        for (Session* session : incoming) {
+            std::lock_guard<std::mutex> lock(session->inputMutex);
+            session->state = Session::State::ACTIVE;
+            active.push_back(session);
+        }
+
+        uint64_t start = Profiler::now();
+        pool.parallelFor(static_cast<int>(active.size()), [&](int i) { active[i]->step(start); }, batchSize);
+
+        // parked sessions leave the schedule until they are woken
+        active.erase(std::remove_if(active.begin(), active.end(), [](Session* session) { return session->parkedInStep; }),
+                     active.end());
+
+        uint64_t time = Profiler::now() - start;
+        ticks++;
+        totalTickTime += time;
+        maxTickTime = std::max(maxTickTime, time);
+        if (time > timestep.getStepNanoseconds())
+            lateTicks++;
+    }
+
+    void SessionHost::run(const std::atomic<bool>& running) {
+        // never sleep longer than a step
+        const auto maxWait = std::chrono::microseconds(static_cast<long long>(timestep.getStep() * 1000 * 1000));
+        auto lastTime = std::chrono::steady_clock::now();
+        timestep.reset();
+
+        while (running) {
+            auto now = std::chrono::steady_clock::now();
+            double elapsed = std::chrono::duration<double>(now - lastTime).count();
+            lastTime = now;
+
+            int steps = timestep.advance(elapsed);
+            for (int i = 0; i < steps; i++) {
+                tick();
+            }
+
+            auto wait = std::min(maxWait, std::chrono::microseconds(static_cast<long long>(timestep.getTimeToNextStep() * 1000 * 1000)));
+            std::this_thread::sleep_until(now + wait);
+        }
+    }
+
+    void SessionHost::writeReport(std::ostream& out) {
+        std::vector<double> means;
+        std::vector<double> maxima;
+        uint64_t steps = 0;
+        for (const auto& session : sessions) {
+            const Session::Stats& stats = session->getStats();
+            steps += stats.steps;
+            if (stats.steps == 0) continue;
+            means.push_back(stats.getMeanLatency());
+            maxima.push_back(static_cast<double>(stats.maxLatency));
+        }
+
+        out << "sessions " << sessions.size() << ", active " << active.size()
+            << ", waiting for input " << sessions.size() - active.size() << "\n";
+        out << "ticks " << ticks << ", mean " << (ticks > 0 ? totalTickTime / ticks : 0) / 1e6 << " ms"
+            << ", max " << maxTickTime / 1e6 << " ms, late " << lateTicks
+            << ", dropped steps " << timestep.getDroppedSteps() << "\n";
+        out << "session steps " << steps << "\n";
+
+        // spread over the sessions, in microseconds
+        auto writeSpread = [&](const char* name, std::vector<double>& values) {
+            if (values.empty()) return;
+            std::sort(values.begin(), values.end());
+            auto percentile = [&](double p) { return values[static_cast<size_t>(p * (values.size() - 1))] / 1e3; };
+            out << name << " latency us, p50 " << percentile(0.5) << ", p90 " << percentile(0.9)
+                << ", p99 " << percentile(0.99) << ", max " << values.back() / 1e3 << "\n";
+        };
+        writeSpread("mean", means);
+        writeSpread("max", maxima);
+    }
+
+}
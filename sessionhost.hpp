@@ -0,0 +1,163 @@
+#ifndef SESSIONHOST_HPP
+#define SESSIONHOST_HPP
+
+#include "physics.hpp"
+#include "taskpool.hpp"
+#include "timestep.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace golf
+{
+
+    class SessionHost;
+
+    // one game run by a SessionHost, stepped on the workers of the host
+    // input can be submitted from any thread, it is applied before the next step of the session
+    // the session keeps its own step count, so it plays out like a replay of the same input
+    class Session
+    {
+        friend class SessionHost;
+
+    public:
+        struct Stats
+        {
+            uint64_t steps = 0;
+            // nanoseconds from the start of the host tick to the end of the step of this session,
+            // time spent queued behind other sessions included
+            uint64_t lastLatency = 0;
+            uint64_t maxLatency = 0;
+            uint64_t totalLatency = 0;
+            // times the session parked waiting for input
+            uint64_t parks = 0;
+
+            double getMeanLatency() const { return steps > 0 ? static_cast<double>(totalLatency) / steps : 0; }
+        };
+
+    private:
+        enum class State
+        {
+            ACTIVE,
+            PARKED,
+            // input arrived while parked, stepped again from the next tick on
+            WOKEN
+        };
+
+        SessionHost &host;
+        int id;
+        Game game;
+        PhysicsWorld physics;
+        uint64_t currentStep = 0;
+        Stats stats;
+
+        // guards the input and the state, everything else is only touched by the step of the session
+        std::mutex inputMutex;
+        State state = State::ACTIVE;
+        Vec3 pendingShot;
+        bool hasPendingShot = false;
+        int pendingGravity = 0;
+        bool hasPendingGravity = false;
+        // set by the step, read by the host once all steps of the tick are done
+        bool parkedInStep = false;
+
+        // applies the input, advances the game and parks it if there is nothing left to do
+        void step(uint64_t tickStart);
+        // aiming with every ball at rest, the next steps would change nothing but moving obstacles
+        bool isWaitingForInput();
+        void wakeLocked();
+
+        // created through SessionHost::createSession
+        Session(SessionHost &host, int id);
+
+    public:
+        Session(const Session &) = delete;
+        Session &operator=(const Session &) = delete;
+
+        int getId() const { return id; }
+        // only safe to use while the session is parked or the host is not ticking
+        Game &getGame() { return game; }
+        PhysicsWorld &getPhysics() { return physics; }
+        uint64_t getCurrentStep() const { return currentStep; }
+        // read between ticks, the workers write them during a tick
+        const Stats &getStats() const { return stats; }
+        bool isParked();
+
+        // taken the next time the current player aims, wakes the session
+        void submitShot(const Vec3 &velocity);
+        void submitGravity(int degrees);
+    };
+
+    // runs many sessions on a fixed worker pool
+    // every tick steps the active sessions once, spread over the workers in batches,
+    // a session that waits for input is parked and costs nothing until input arrives for it
+    // the clock of a parked session stands still, its moving obstacles carry on where they stopped
+    // sessions are created, removed and ticked from one thread, input comes from any thread
+    class SessionHost
+    {
+        friend class Session;
+
+    private:
+        TaskPool &pool;
+        FixedTimestep timestep;
+        std::vector<std::unique_ptr<Session>> sessions;
+        int nextId = 0;
+        // sessions stepped by the next tick
+        std::vector<Session *> active;
+        // sessions woken since the last tick, guarded by wakeMutex
+        std::mutex wakeMutex;
+        std::vector<Session *> woken;
+        // sessions handed to one task of the pool
+        int batchSize = 16;
+        std::function<void(Session &)> inputListener;
+
+        uint64_t ticks = 0;
+        uint64_t totalTickTime = 0;
+        uint64_t maxTickTime = 0;
+        // ticks that took longer than a step
+        uint64_t lateTicks = 0;
+
+        void wake(Session &session);
+
+    public:
+        explicit SessionHost(TaskPool &pool, double step = 1.0 / 60);
+
+        SessionHost(const SessionHost &) = delete;
+        SessionHost &operator=(const SessionHost &) = delete;
+
+        // starts a new game, it is stepped from the next tick on
+        Session &createSession();
+        void removeSession(Session &session);
+        // nullptr if there is no session with the id
+        Session *findSession(int id);
+
+        // called on a worker right after a session parked,
+        // the game can be read until input is submitted for it, which may be done from inside the listener
+        void setInputListener(const std::function<void(Session &)> &listener) { inputListener = listener; }
+        void setBatchSize(int batchSize) { this->batchSize = batchSize; }
+
+        // steps every active session once and returns when all of them are done
+        void tick();
+        // ticks in real time at the step of the host until running turns false,
+        // a backlog of more than the maximum steps of the timestep is dropped
+        void run(const std::atomic<bool> &running);
+
+        double getStep() const { return timestep.getStep(); }
+        int getSessionCount() const { return static_cast<int>(sessions.size()); }
+        // sessions the next tick steps, woken ones are counted from the tick after their input
+        int getActiveCount() const { return static_cast<int>(active.size()); }
+        uint64_t getTicks() const { return ticks; }
+        uint64_t getLateTicks() const { return lateTicks; }
+        uint64_t getDroppedSteps() const { return timestep.getDroppedSteps(); }
+
+        // tick times and the spread of the session latencies, read between ticks
+        void writeReport(std::ostream &out);
+    };
+
+}
+
+#endif // SESSIONHOST_HPP
@@ -0,0 +1,120 @@
+#include "shotsolver.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace golf {
+
+    double ShotSolver::random(int round, int sample, int dimension) const {
+        // splitmix64 over seed and sample, cheap enough to hash per number
+        unsigned long long x = seed;
+        x ^= (static_cast<unsigned long long>(round) << 48) ^ (static_cast<unsigned long long>(sample) << 8) ^ static_cast<unsigned long long>(dimension);
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return (x >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    Vec3 ShotSolver::shotVelocity(double angle, double power) {
+        return Vec3(cos(angle), 0, sin(angle)) * power;
+    }
+
+    bool ShotSolver::isBetter(const Shot& shot, const Shot& other) {
+        if (shot.holed != other.holed) return shot.holed;
+        // the faster of two holing shots
+        if (shot.holed) return shot.steps < other.steps;
+        return shot.cost < other.cost;
+    }
+
+    ShotSolver::Shot ShotSolver::rollout(const Sphere& ball, const Vec3& velocity) {
+        Course& course = physics.getGame().getCourse();
+
+        Shot shot;
+        shot.velocity = velocity;
+
+        Sphere sphere = ball;
+        sphere.setVelocity(velocity);
+        sphere.wake();
+
+        while (shot.steps < maxSteps) {
+            // the course is queried with the bounds of the step, see Course::collide
+            sphere.storePreviousPosition();
+            physics.advanceBall(sphere, step);
+            shot.steps++;
+
+            if (course.isInHole(sphere)) {
+                shot.holed = true;
+                break;
+            }
+            // same as Game::tick, the ball goes back to the start
+            if (sphere.getPosition().y < -10) {
+                shot.outOfBounds = true;
+                break;
+            }
+            if (sphere.isSleeping()) break;
+        }
+
+        shot.restPosition = shot.outOfBounds ? course.getStartPosition() : sphere.getPosition();
+        shot.cost = shot.holed ? 0 : shot.restPosition.getDistance(course.getHolePosition());
+        if (shot.outOfBounds) shot.cost += outOfBoundsPenalty;
+        return shot;
+    }
+
+    ShotSolver::Shot ShotSolver::solve(const Sphere& ball) {
+        // built lazily otherwise, the rollouts read it from every worker
+        physics.getGame().prepareCollision();
+
+        double maxPower = physics.getGame().getController().getMaxLength();
+        shots.clear();
+
+        // stratified over direction and power, jittered inside every cell
+        int powerSteps = std::max(1, static_cast<int>(sqrt(sampleCount / 8.0)));
+        int angleSteps = std::max(1, sampleCount / powerSteps);
+        int count = angleSteps * powerSteps;
+        shots.resize(count);
+        pool.parallelFor(count, [&](int i) {
+            double angle = (i % angleSteps + random(0, i, 0)) / angleSteps * 2 * PI;
+            double power = (i / angleSteps + random(0, i, 1)) / powerSteps * maxPower;
+            shots[i] = rollout(ball, shotVelocity(angle, power));
+        }, 4);
+
+        // refine around the best shots so far, the spread starts at the size of a cell
+        double angleSpread = 2 * PI / angleSteps;
+        double powerSpread = maxPower / powerSteps;
+        std::vector<int> order;
+        std::vector<Shot> elite;
+        for (int round = 1; round <= refineRounds; round++) {
+            order.resize(shots.size());
+            std::iota(order.begin(), order.end(), 0);
+            int best = std::min(eliteCount, static_cast<int>(order.size()));
+            // stable, so equal shots keep the order they were sampled in
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return isBetter(shots[a], shots[b]); });
+            if (shots[order[0]].holed) break;
+
+            elite.clear();
+            for (int i = 0; i < best; i++) elite.push_back(shots[order[i]]);
+
+            size_t first = shots.size();
+            shots.resize(first + refineSampleCount);
+            pool.parallelFor(refineSampleCount, [&](int i) {
+                const Shot& parent = elite[i % elite.size()];
+                double angle = atan2(parent.velocity.z, parent.velocity.x);
+                double power = parent.velocity.length();
+                angle += (random(round, i, 0) * 2 - 1) * angleSpread;
+                power += (random(round, i, 1) * 2 - 1) * powerSpread;
+                power = std::min(std::max(power, 0.0), maxPower);
+                shots[first + i] = rollout(ball, shotVelocity(angle, power));
+            }, 4);
+
+            angleSpread *= refineShrink;
+            powerSpread *= refineShrink;
+        }
+
+        Shot best = shots[0];
+        for (const Shot& shot : shots) {
+            if (isBetter(shot, best)) best = shot;
+        }
+        return best;
+    }
+
+}
@@ -0,0 +1,83 @@
+#ifndef SHOTSOLVER_HPP
+#define SHOTSOLVER_HPP
+
+#include "physics.hpp"
+#include "taskpool.hpp"
+#include <vector>
+
+namespace golf
+{
+
+    // searches for the shot that gets a ball closest to the hole of the current course
+    // candidate shots are rolled out headless on the pool, first spread over all directions and powers,
+    // then in a few rounds of samples around the best shots so far with a shrinking spread
+    // the rollouts only read the course and ignore the other balls, moving obstacles stay where they are while solving,
+    // so solve has to run on the thread that steps the game, between two steps
+    class ShotSolver
+    {
+
+    public:
+        struct Shot
+        {
+            // what Controller::tick would pass to Game::shootBall
+            Vec3 velocity;
+            // where the ball comes to rest, the start position of the course if it fell off
+            Vec3 restPosition;
+            // distance of the rest position to the hole plus penalties, lower is better
+            double cost = 0;
+            bool holed = false;
+            bool outOfBounds = false;
+            int steps = 0;
+        };
+
+    private:
+        PhysicsWorld &physics;
+        TaskPool &pool;
+
+        int sampleCount = 1024;
+        int refineRounds = 3;
+        int refineSampleCount = 256;
+        // best shots the refine rounds sample around
+        int eliteCount = 8;
+        // spread of the refine samples is scaled by this each round
+        double refineShrink = 0.4;
+        unsigned long long seed = 1;
+
+        // rollouts run at the rate of the game and give up after maxSteps
+        // or when the ball falls asleep, see PhysicsWorld::updateSleep
+        double step = 1.0 / 60;
+        int maxSteps = 900;
+        // added to the cost of a shot that leaves the course, it costs a stroke
+        double outOfBoundsPenalty = 10;
+
+        std::vector<Shot> shots;
+
+        // uniform in [0, 1), the same for the same sample no matter which thread rolls it out
+        double random(int round, int sample, int dimension) const;
+        // flat shot of the given power, angle in radians around the y axis
+        static Vec3 shotVelocity(double angle, double power);
+        static bool isBetter(const Shot &shot, const Shot &other);
+
+    public:
+        ShotSolver(PhysicsWorld &physics, TaskPool &pool) : physics(physics), pool(pool) {}
+
+        void setSampleCount(int sampleCount) { this->sampleCount = sampleCount; }
+        void setRefineRounds(int refineRounds) { this->refineRounds = refineRounds; }
+        void setRefineSampleCount(int refineSampleCount) { this->refineSampleCount = refineSampleCount; }
+        void setSeed(unsigned long long seed) { this->seed = seed; }
+        int getSampleCount() { return sampleCount; }
+        int getRefineRounds() { return refineRounds; }
+        int getRefineSampleCount() { return refineSampleCount; }
+
+        // best shot for a ball, holing shots win over all others, then the lowest cost
+        // stops refining as soon as a shot holes the ball
+        Shot solve(const Sphere &ball);
+        // simulates one shot of the ball until it rests, falls off or is holed
+        Shot rollout(const Sphere &ball, const Vec3 &velocity);
+        // rollouts of the last solve, in the order they were sampled
+        const std::vector<Shot> &getShots() const { return shots; }
+    };
+
+}
+
+#endif // SHOTSOLVER_HPP
@@ -0,0 +1,61 @@
+# Headless simulation core
+# Shared by the A08 app and any render-less tool that wants to step a golf::Game
+# without a widget or a gl context. Include it with include(simcore.pri).
+
+CONFIG  += c++17
+
+QT      += core gui
+
+win32: LIBS += -lOpengl32
+unix:!macx: LIBS += -lGL -lpthread
+
+# DEFINES += GOLF_NO_PROFILER compiles out every PROFILE_SCOPE, see profiler.hpp
+# DEFINES += GOLF_FLOAT_PHYSICS or GOLF_PACKED_PHYSICS picks the Vec3 precision, see vec3.hpp
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/arena.cpp \
+           $$PWD/ballbroadphase.cpp \
+           $$PWD/batchsimulator.cpp \
+           $$PWD/bvh.cpp \
+           $$PWD/collisionmesh.cpp \
+           $$PWD/drawmesh.cpp \
+           $$PWD/minigolf.cpp \
+           $$PWD/obstacles.cpp \
+           $$PWD/physics.cpp \
+           $$PWD/profiler.cpp \
+           $$PWD/renderstate.cpp \
+           $$PWD/replay.cpp \
+           $$PWD/sessionhost.cpp \
+           $$PWD/shotsolver.cpp \
+           $$PWD/simulation.cpp \
+           $$PWD/spheremesh.cpp \
+           $$PWD/sweep.cpp \
+           $$PWD/taskpool.cpp \
+           $$PWD/terrain.cpp \
+           $$PWD/timestep.cpp \
+           $$PWD/trianglekernel.cpp
+
+HEADERS += $$PWD/arena.hpp \
+           $$PWD/ballbroadphase.hpp \
+           $$PWD/batchsimulator.hpp \
+           $$PWD/bvh.hpp \
+           $$PWD/collisionmesh.hpp \
+           $$PWD/drawmesh.hpp \
+           $$PWD/minigolf.hpp \
+           $$PWD/obstacles.hpp \
+           $$PWD/physics.hpp \
+           $$PWD/profiler.hpp \
+           $$PWD/renderstate.hpp \
+           $$PWD/replay.hpp \
+           $$PWD/sessionhost.hpp \
+           $$PWD/shotsolver.hpp \
+           $$PWD/simulation.hpp \
+           $$PWD/spheremesh.hpp \
+           $$PWD/sweep.hpp \
+           $$PWD/taskpool.hpp \
+           $$PWD/terrain.hpp \
+           $$PWD/timestep.hpp \
+           $$PWD/trianglekernel.hpp \
+           $$PWD/triplebuffer.hpp \
+           $$PWD/vec3.hpp
@@ -1,7 +1,14 @@
 
 #include "simulation.hpp"
-#include "oglwidget.h"
+#include "arena.hpp"
+#include "collisionmesh.hpp"
+#include "drawmesh.hpp"
+#include "spheremesh.hpp"
+#include "sweep.hpp"
 #include <iostream>
+#include <algorithm>
+
+bool SimObject::showAxis = false;
 
 void glNormalVec3(const Vec3 &v)
 {
@@ -16,13 +23,32 @@ void glVertexVecVec3(const std::vector<Vec3> &v)
     }
 }
 
+// move that takes a sphere depth deep out of a surface along its new direction
+// a grazing fast sphere would be slid far along the surface and through whatever is behind it,
+// so if that move is longer than the radius it goes straight out along the collision normal instead
+static Vec3 pushOut(const Vec3 &reflection, const Vec3 &collToCenter, double depth, double radius)
+{
+    if (reflection.lengthSquared() == 0)
+        return collToCenter * depth;
+    auto direction = physicsNormalized(reflection);
+    double cosAngle = collToCenter.dot(direction);
+    if (!(depth < radius * abs(cosAngle)))
+        return collToCenter * depth;
+    return direction * depth * (1 / cosAngle);
+}
+
 // collision of sphere with wall
 bool Wall::collide(Sphere &sphere)
 {
+    updateWorldData();
+    return collideWorld(sphere, worldCorners.data(), basis);
+}
+
+bool Wall::collideWorld(Sphere &sphere, const Vec3 *worldCorners, const WallBasis &basis)
+{
+    const auto &normal = basis.normal;
 
     // cheap distance check first
-    auto normal = getNormal();
-    auto worldCorners = getWorldCorners();
     const auto &point = worldCorners[0];
     const auto center = sphere.getWorldPosition();
     auto radius = sphere.getRadius();
@@ -47,7 +73,9 @@ bool Wall::collide(Sphere &sphere)
             sphere.setVelocity(reflection);
 
             // move sphere out of corner
-            Vec3 move = reflection.normalized() * (radius - dist + 0.001);
+            // a sphere friction brought to a stop has no direction to go, it is pushed straight away from the corner
+            Vec3 direction = reflection.lengthSquared() > 0 ? reflection.normalized() : vec.normalized();
+            Vec3 move = direction * (radius - dist + 0.001);
             sphere.move(move);
             return true;
         }
@@ -59,8 +87,7 @@ bool Wall::collide(Sphere &sphere)
     {
         auto &corner1 = worldCorners[i];
         auto &corner2 = worldCorners[(i + 1) % 4];
-        auto edge = corner2 - corner1;
-        auto edgeNormalized = edge.normalized();
+        const auto &edgeNormalized = basis.edgeDirection[i];
 
         auto ca = center - corner1;
 
@@ -80,7 +107,7 @@ bool Wall::collide(Sphere &sphere)
         // check if collision point is between both worldCorners by checking if distance |p-corner1| + |p-corner2| is equal to |corner1-corner2|
         auto dist1 = p.getDistance(corner1);
         auto dist2 = p.getDistance(corner2);
-        auto dist3 = corner1.getDistance(corner2);
+        auto dist3 = basis.edgeLength[i];
         constexpr double tolerance = 0.01;
         if (dist1 + dist2 > dist3 + tolerance)
             continue;
@@ -88,12 +115,12 @@ bool Wall::collide(Sphere &sphere)
         // collision confirmed, calculate reflection
         // calculate reflection vector
         auto collToCenter = center - p;
-        collToCenter = collToCenter.normalized();
-        auto reflection = sphereVelocity - 2 * sphereVelocity.dot(collToCenter) * collToCenter;
+        collToCenter = physicsNormalized(collToCenter);
+        auto reflection = physicsMultiplyAdd(sphereVelocity, collToCenter, -2 * sphereVelocity.dot(collToCenter));
         sphere.setVelocity(reflection);
 
         // move sphere out of wall
-        Vec3 move = reflection.normalized() * (radius - abs(cpdist) + 0.001) * (1 / collToCenter.dot(reflection.normalized()));
+        Vec3 move = pushOut(reflection, collToCenter, radius - abs(cpdist) + 0.001, radius);
         sphere.move(move);
     }
 
@@ -116,36 +143,20 @@ bool Wall::collide(Sphere &sphere)
     // wall[2] = 1/1
     // wall[3] = 1/0
 
-    // create vectors to span rectangle
-    auto v1 = worldCorners[1] - worldCorners[0];
-    auto v2 = worldCorners[3] - worldCorners[0];
-
-    // normalize
-    v1 = v1.normalized();
-    v2 = v2.normalized();
-
-    // create vector to span z axis (this should just be the plane normal?)
-    auto n = v1.cross(v2).normalized();
-
+    // the vectors spanning the rectangle and the normal of both are in the basis, see WallBasis
     // convert a point to 2d:
     // px = v1.dot(p - worldCorners[0])
     // py = v2.dot(p - worldCorners[0])
     // pz = n.dot(p - worldCorners[0])
     // pz should be 0 and can be ignored, px and py form the 2d point
 
-    // max values for height and width
-    auto topRight = worldCorners[2] - worldCorners[0];
-    auto trX = v1.dot(topRight);
-    auto trY = v2.dot(topRight);
-    // auto trZ = n.dot(topRight);
-
     // vector from corner to point
     auto pnew = p - worldCorners[0];
 
-    // calculate px, py and pz
-    auto px = v1.dot(pnew) / trX;
-    auto py = v2.dot(pnew) / trY;
-    auto pz = n.dot(pnew);
+    // calculate px, py and pz, scaled so the wall spans 0 to 1
+    auto px = basis.axisX.dot(pnew) * basis.invExtentX;
+    auto py = basis.axisY.dot(pnew) * basis.invExtentY;
+    auto pz = basis.axisZ.dot(pnew);
 
     // check if pz is 0 with tolerance
     // should always be near 0 since we already checked distance
@@ -206,11 +217,11 @@ bool Wall::collide(Sphere &sphere)
     // instead of normal use collToCenter
     // this is the same direction as the normal, but it can be negative if the sphere is on the other side of the wall
     auto collToCenter = center - p;
-    collToCenter = collToCenter.normalized();
+    collToCenter = physicsNormalized(collToCenter);
     auto reflection = sphereVelocity - 2 * sphereVelocity.dot(collToCenter) / pow(collToCenter.length(), 2) * collToCenter;
     sphere.setVelocity(reflection);
     // move sphere out of wall
-    Vec3 move = reflection.normalized() * (radius - dist + 0.001) * (1 / collToCenter.dot(reflection.normalized()));
+    Vec3 move = pushOut(reflection, collToCenter, radius - dist + 0.001, radius);
 
     sphere.move(move);
 
@@ -219,6 +230,16 @@ bool Wall::collide(Sphere &sphere)
 
 // applies new velocity to object with consideration of bounce or friction
 void SimObject::applyCollisionVelocity(const Vec3& newVelocity, const Vec3& otherNormal, const SimObject& other) {
+    applyCollisionVelocity(newVelocity, otherNormal, other.getSurface());
+}
+
+void SimObject::applyCollisionVelocity(const Vec3& newVelocity, const Vec3& otherNormal, const Surface& other) {
+
+    // nothing to bounce or roll, a sphere standing still stays so
+    if (newVelocity.lengthSquared() == 0) {
+        this->velocity = newVelocity;
+        return;
+    }
 
     // check if collision is a bounce or roll
     double dot = newVelocity.normalized().dot(otherNormal);
@@ -267,7 +288,7 @@ void Sphere::bounce(Sphere &other)
 
     // calculate new velocities
     // collision point based on radius
-    auto coll = (p1 - p2).normalized() * this->getRadius();
+    auto coll = physicsNormalized(p1 - p2) * this->getRadius();
     coll += p1;
     // calculate new velocities
     // new vel = old vel - 2 * massFactor * collisionFactor / distance^2 * collisionVector
@@ -288,19 +309,40 @@ void Sphere::bounce(Sphere &other)
     other.move(move * -1);
 }
 
-double Vec3::getDistance(const Vec3 &other)
+namespace {
+    // in front of every SimObject, keeps the object itself aligned
+    struct alignas(std::max_align_t) AllocationHeader
+    {
+        golf::Arena *arena;
+    };
+}
+
+void *SimObject::operator new(std::size_t size)
 {
-    return sqrt(pow(this->x - other.x, 2) + pow(this->y - other.y, 2) + pow(this->z - other.z, 2));
+    size += sizeof(AllocationHeader);
+    golf::Arena *arena = golf::Arena::current();
+    void *memory = arena != nullptr ? arena->allocate(size, alignof(AllocationHeader)) : ::operator new(size);
+    AllocationHeader *header = static_cast<AllocationHeader *>(memory);
+    header->arena = arena;
+    return header + 1;
 }
 
-Vec3 Vec3::getNormal(const Vec3 &other1, const Vec3 &other2)
+void SimObject::operator delete(void *p)
 {
-    Vec3 v1 = other1 - *this;
-    Vec3 v2 = other2 - *this;
-    return v1.cross(v2).normalized();
+    if (p == nullptr)
+        return;
+    AllocationHeader *header = static_cast<AllocationHeader *>(p) - 1;
+    // arena memory goes away with the arena
+    if (header->arena == nullptr)
+        ::operator delete(header);
 }
 
 double SimObject::calcBounceFactor(const SimObject &other)
+{
+    return calcBounceFactor(other.getSurface());
+}
+
+double SimObject::calcBounceFactor(const Surface &other)
 {
 
     double factor = (other.bounceFactor * this->bounceFactor);
@@ -319,13 +361,101 @@ void SimObject::tick(double time)
 void SimObject::setPosition(Vec3 position)
 {
     this->position = position;
-    auto myPos = this->getWorldPosition();
+    transformDirty = true;
+}
+
+// rotates v by the upper 3x3 of m
+static Vec3 rotate(const QMatrix4x4 &m, const Vec3 &v)
+{
+    return Vec3(m(0, 0) * v.x + m(0, 1) * v.y + m(0, 2) * v.z,
+                m(1, 0) * v.x + m(1, 1) * v.y + m(1, 2) * v.z,
+                m(2, 0) * v.x + m(2, 1) * v.y + m(2, 2) * v.z);
+}
+
+SimObject::Rotation &SimObject::Rotation::operator=(const Rotation &other)
+{
+    matrices.reset(other.matrices ? new Matrices(*other.matrices) : nullptr);
+    return *this;
+}
+
+const QMatrix4x4 &SimObject::Rotation::getLocal() const
+{
+    static const QMatrix4x4 identity;
+    return matrices ? matrices->local : identity;
+}
+
+const QMatrix4x4 &SimObject::Rotation::getWorld() const
+{
+    static const QMatrix4x4 identity;
+    return matrices ? matrices->world : identity;
+}
+
+void SimObject::Rotation::setLocal(const QMatrix4x4 &local)
+{
+    if (!matrices) matrices.reset(new Matrices);
+    matrices->local = local;
+}
+
+void SimObject::Rotation::setWorld(const QMatrix4x4 &world)
+{
+    if (!matrices) matrices.reset(new Matrices);
+    matrices->world = world;
+}
+
+void SimObject::updateWorldTransform()
+{
+    if (parent != nullptr)
+    {
+        parent->updateWorldTransform();
+        if (parent->worldVersion != parentVersion)
+            transformDirty = true;
+    }
+    if (!transformDirty)
+        return;
+
+    bool parentRotated = parent != nullptr && parent->worldRotated;
+    if (parent == nullptr)
+    {
+        worldPosition = position;
+    }
+    else
+    {
+        // unrotated parents, which is almost all of them, add up exactly as before
+        worldPosition = parent->worldPosition + (parentRotated ? rotate(parent->rotation.getWorld(), position) : position);
+        parentVersion = parent->worldVersion;
+    }
+    // neither this object nor a parent is rotated, the matrices stay unallocated
+    if (parentRotated)
+        rotation.setWorld(parent->rotation.getWorld() * rotation.getLocal());
+    else if (rotation.isAllocated())
+        rotation.setWorld(rotation.getLocal());
+    worldRotated = rotation.isAllocated() && !rotation.getWorld().isIdentity();
+    worldVersion++;
+    transformDirty = false;
+}
+
+void SimObject::updateWorldTransforms()
+{
+    updateWorldTransform();
+    updateWorldData();
     for (SimObject *child : children)
     {
-        child->setWorldPosition(myPos);
+        child->updateWorldTransforms();
     }
 }
 
+Vec3 SimObject::toWorld(const Vec3 &local)
+{
+    updateWorldTransform();
+    return worldPosition + (worldRotated ? rotate(rotation.getWorld(), local) : local);
+}
+
+Vec3 SimObject::toWorldDirection(const Vec3 &local)
+{
+    updateWorldTransform();
+    return worldRotated ? rotate(rotation.getWorld(), local) : local;
+}
+
 bool SimObject::collide(Sphere& sphere) {
     // check collision with children
     bool collided = false;
@@ -336,28 +466,39 @@ bool SimObject::collide(Sphere& sphere) {
     return collided;
 }
 
-void SimObject::setWorldPosition(Vec3 position)
+bool SimObject::sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t)
 {
-    this->worldPosition = position;
-    auto myPos = this->getWorldPosition();
+    // earliest impact of all children
+    bool found = false;
+    double hit;
     for (SimObject *child : children)
     {
-        child->setWorldPosition(myPos);
+        if (child->sweep(start, motion, radius, hit) && (!found || hit < t))
+        {
+            t = hit;
+            found = true;
+        }
     }
+    return found;
 }
 
 void SimObject::addChild(SimObject *child)
 {
     children.push_back(child);
     child->parent = this;
-    child->setWorldPosition(this->getWorldPosition());
+    child->transformDirty = true;
 }
 
 void SimObject::draw()
+{
+    drawAt(position);
+}
+
+void SimObject::drawAt(const Vec3 &position)
 {
     glPushMatrix();
     glTranslatef(position.x, position.y, position.z);
-    glMultMatrixf(rotation.data());
+    glMultMatrixf(getRotation().data());
 
     // draw children
     for (SimObject *child : children)
@@ -393,9 +534,19 @@ void Triangle::draw()
 
 bool Triangle::collide(Sphere &sphere)
 {
-    // cheap distance check first
-    auto normal = getNormal();
+    // cheap distance check first, before the basis is built
+    auto normal = getWorldNormal();
     auto worldCorners = getWorldCorners();
+    if (abs(normal.dot(sphere.getWorldPosition() - worldCorners[0])) > sphere.getRadius())
+        return false;
+
+    TriangleBasis basis(worldCorners[0], worldCorners[1], worldCorners[2]);
+    return collideWorld(sphere, worldCorners.data(), normal, basis, getSurface(), faceCollisionOnly);
+}
+
+bool Triangle::collideWorld(Sphere &sphere, const Vec3 *worldCorners, const Vec3 &normal, const TriangleBasis &basis, const Surface &surface, bool faceCollisionOnly)
+{
+    // cheap distance check first
     const auto &point = worldCorners[0];
     const auto center = sphere.getWorldPosition();
     auto radius = sphere.getRadius();
@@ -405,7 +556,7 @@ bool Triangle::collide(Sphere &sphere)
     if (dist > radius)
         return false;
 
-    double bounceFactor = sphere.calcBounceFactor(*this);
+    double bounceFactor = sphere.calcBounceFactor(surface);
 
     // check for corner collision here
     if (!faceCollisionOnly)
@@ -420,8 +571,9 @@ bool Triangle::collide(Sphere &sphere)
                 auto reflection = sphereVelocity - 2 * sphereVelocity.dot(normal) / pow(normal.length(), 2) * normal;
                 sphere.setVelocity(reflection*bounceFactor);
 
-                // move sphere out of corner
-                Vec3 move = reflection.normalized() * (radius - dist + 0.001);
+                // move sphere out of corner, straight away from it if the sphere stands still
+                Vec3 direction = reflection.lengthSquared() > 0 ? reflection.normalized() : vec.normalized();
+                Vec3 move = direction * (radius - dist + 0.001);
                 sphere.move(move);
                 return true;
             }
@@ -462,53 +614,64 @@ bool Triangle::collide(Sphere &sphere)
             // collision confirmed, calculate reflection
             // calculate reflection vector
             auto collToCenter = center - p;
-            collToCenter = collToCenter.normalized();
-            auto reflection = sphereVelocity - 2 * sphereVelocity.dot(collToCenter) * collToCenter;
+            collToCenter = physicsNormalized(collToCenter);
+            auto reflection = physicsMultiplyAdd(sphereVelocity, collToCenter, -2 * sphereVelocity.dot(collToCenter));
             sphere.setVelocity(reflection*bounceFactor);
 
             // move sphere out of wall
-            Vec3 move = reflection.normalized() * (radius - abs(cpdist) + 0.001) * (1 / collToCenter.dot(reflection.normalized()));
+            Vec3 move = pushOut(reflection, collToCenter, radius - abs(cpdist) + 0.001, radius);
             sphere.move(move);
         }
 
     // check if sphere collides with face
     // already in range of plane, check if collisionpoint is inside face
+    return collideFace(sphere, center, sphereVelocity, worldCorners[0], normal, basis, surface);
+}
+
+TriangleBasis::TriangleBasis(const Vec3 &a, const Vec3 &b, const Vec3 &c)
+{
+    // vectors from a to b and a to c
+    v0 = c - a;
+    v1 = b - a;
+
+    // dot products
+    dot00 = v0.dot(v0);
+    dot01 = v0.dot(v1);
+    dot11 = v1.dot(v1);
+
+    // inverse denominator to avoid division later
+    invDenom = 1.0 / (dot00 * dot11 - dot01 * dot01);
+}
+
+bool Triangle::collideFace(Sphere &sphere, const Vec3 &center, const Vec3 &sphereVelocity, const Vec3 &a, const Vec3 &normal, const TriangleBasis &basis, const Surface &surface)
+{
     // face normal: normal
-    // face point: worldCorners[0]
+    // face point: a
+    const auto &point = a;
+    auto radius = sphere.getRadius();
 
     // calculate closest point on plate to sphere center
 
     // use non abs distance to get direction
     auto newDist = normal.dot(center - point);
+    auto dist = abs(newDist);
+    if (dist > radius)
+        return false;
     auto p = center - newDist * normal;
 
-    // check if collision point is between all worldCorners
+    // check if collision point is between all corners
 
     // barycentric approach
 
     // calculate using barycentric coordinates
-    auto &a = worldCorners[0];
-    auto &b = worldCorners[1];
-    auto &c = worldCorners[2];
-
-    // vectors from a to b and a to c and a to p
-    Vec3 v0 = c - a;
-    Vec3 v1 = b - a;
+    // the basis holds the vectors from a to c and a to b, only a to p is new
     Vec3 v2 = p - a;
-
-    // dot products
-    double dot00 = v0.dot(v0);
-    double dot01 = v0.dot(v1);
-    double dot02 = v0.dot(v2);
-    double dot11 = v1.dot(v1);
-    double dot12 = v1.dot(v2);
-
-    // inverse denominator to avoid division later
-    double invDenom = 1.0 / (dot00 * dot11 - dot01 * dot01);
+    double dot02 = basis.v0.dot(v2);
+    double dot12 = basis.v1.dot(v2);
 
     // barycentric coordinates
-    double u = (dot11 * dot02 - dot01 * dot12) * invDenom;
-    double v = (dot00 * dot12 - dot01 * dot02) * invDenom;
+    double u = (basis.dot11 * dot02 - basis.dot01 * dot12) * basis.invDenom;
+    double v = (basis.dot00 * dot12 - basis.dot01 * dot02) * basis.invDenom;
 
     // check if point is in triangle
     double tolerance = 0;
@@ -522,27 +685,85 @@ bool Triangle::collide(Sphere &sphere)
     // instead of normal use collToCenter
     // this is the same direction as the normal, but it can be negative if the sphere is on the other side of the wall
     auto collToCenter = center - p;
-    collToCenter = collToCenter.normalized();
+    collToCenter = physicsNormalized(collToCenter);
     auto reflection = sphereVelocity - 2 * sphereVelocity.dot(collToCenter) / pow(collToCenter.length(), 2) * collToCenter;
-    sphere.applyCollisionVelocity(reflection, normal, *this);
+    sphere.applyCollisionVelocity(reflection, normal, surface);
     // move sphere out of wall
-    Vec3 move = reflection.normalized() * (radius - dist + 0.001) * (1 / collToCenter.dot(reflection.normalized()));
+    Vec3 move = pushOut(reflection, collToCenter, radius - dist + 0.001, radius);
 
     sphere.move(move);
 
     return true;
 }
 
-std::vector<Vec3> Triangle::getWorldCorners()
+std::array<Vec3, 3> Triangle::getWorldCorners()
 {
-    auto worldPos = getWorldPosition();
     return {
-        worldPos + p1,
-        worldPos + p2,
-        worldPos + p3,
+        toWorld(p1),
+        toWorld(p2),
+        toWorld(p3),
     };
 }
 
+bool Triangle::getWorldBounds(AABB &bounds)
+{
+    bounds = AABB();
+    for (const auto &corner : getWorldCorners())
+    {
+        bounds.expand(corner);
+    }
+    return true;
+}
+
+bool Triangle::bake(golf::CollisionMesh &mesh)
+{
+    auto worldCorners = getWorldCorners();
+    mesh.addTriangle(worldCorners[0], worldCorners[1], worldCorners[2], getWorldNormal(), getSurface(), faceCollisionOnly);
+    return true;
+}
+
+bool Triangle::bakeDrawing(golf::DrawMesh &mesh)
+{
+    mesh.setColor(color);
+    mesh.addTriangle(p1, p2, p3, getNormal());
+    return true;
+}
+
+bool Triangle::sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t)
+{
+    auto worldCorners = getWorldCorners();
+    return golf::sweepSphereTriangle(start, motion, radius, worldCorners[0], worldCorners[1], worldCorners[2], t, faceCollisionOnly);
+}
+
+void AABB::expand(const Vec3 &p)
+{
+    min = Vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+    max = Vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+}
+
+void AABB::expand(const AABB &other)
+{
+    if (other.isEmpty())
+        return;
+    expand(other.min);
+    expand(other.max);
+}
+
+bool AABB::overlaps(const AABB &other) const
+{
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+}
+
+double AABB::surfaceArea() const
+{
+    if (isEmpty())
+        return 0;
+    auto d = max - min;
+    return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
 Plane::Plane(Vec3 normal, Vec3 point) : normal(normal), point(point)
 {
     this->normal = this->normal.normalized();
@@ -559,7 +780,7 @@ Vec3 Plane::bounce(const Vec3 &v)
     // skalarprodukt
     double dot = v.dot(normal);
     // reflektionsvektor
-    Vec3 reflection = v - 2 * dot * normal;
+    Vec3 reflection = physicsMultiplyAdd(v, normal, -2 * dot);
     return reflection;
 }
 
@@ -601,96 +822,213 @@ Wall::Wall(const Vec3 &corner1, const Vec3 &corner2, const Vec3 &corner3, const
     corners.push_back(corner4);
 }
 
-std::vector<Vec3> Wall::getWorldCorners()
+void Wall::updateWorldData()
 {
-    auto wPos = this->getWorldPosition();
-    return {
-        corners[0] + wPos,
-        corners[1] + wPos,
-        corners[2] + wPos,
-        corners[3] + wPos};
+    auto version = getWorldVersion();
+    if (version == basisVersion)
+        return;
+    worldCorners = {
+        toWorld(corners[0]),
+        toWorld(corners[1]),
+        toWorld(corners[2]),
+        toWorld(corners[3])};
+    basis = WallBasis(worldCorners.data(), getWorldNormal());
+    basisVersion = version;
 }
 
-void Sphere::draw()
+WallBasis::WallBasis(const Vec3 *corners, const Vec3 &normal) : normal(normal)
 {
-    glPushMatrix();
+    for (int i = 0; i < 4; i++)
+    {
+        edgeDirection[i] = (corners[(i + 1) % 4] - corners[i]).normalized();
+        edgeLength[i] = corners[i].getDistance(corners[(i + 1) % 4]);
+    }
 
-    // position
-    glTranslatef(position.x, position.y, position.z);
+    // vectors to span the rectangle
+    axisX = (corners[1] - corners[0]).normalized();
+    axisY = (corners[3] - corners[0]).normalized();
+    // this should just be the plane normal, but is not bit for bit the same
+    axisZ = axisX.cross(axisY).normalized();
 
-    // draw axis if enabled
-    if (OGLWidget::showAxis)
+    // width and height
+    auto topRight = corners[2] - corners[0];
+    invExtentX = 1.0 / axisX.dot(topRight);
+    invExtentY = 1.0 / axisY.dot(topRight);
+}
+
+bool Wall::getWorldBounds(AABB &bounds)
+{
+    bounds = AABB();
+    for (const auto &corner : getWorldCorners())
     {
-        // draw movement vector
-        auto embiggenedVelocity = velocity.normalized() * radius * 2;
-        glBegin(GL_LINES);
-        glColor3f(1, 0, 0);
-        glVertexNPoints(Vec3(0, 0, 0), embiggenedVelocity);
-        glEnd();
-
-        // draw floor normal
-        auto embiggenedFloorNormal = currentFloorNormal.normalized() * radius * 2;
-        glBegin(GL_LINES);
-        glColor3f(0, 1, 0);
-        glVertexNPoints(Vec3(0, 0, 0), embiggenedFloorNormal);
-        glEnd();
-
-        // draw rotation axis
-        auto embiggenedRotationAxis = currentFloorNormal.cross(velocity).normalized() * radius * 2;
-        glBegin(GL_LINES);
-        glColor3f(0, 0, 1);
-        glVertexNPoints(Vec3(0, 0, 0), embiggenedRotationAxis);
-        glEnd();
+        bounds.expand(corner);
     }
+    return true;
+}
 
-    // rotation
+bool Wall::bake(golf::CollisionMesh &mesh)
+{
+    mesh.addQuad(getWorldCorners(), getWorldNormal());
+    return true;
+}
 
-    // glRotatef(rotation.angle * 180.0 / PI, rotation.axis.x, rotation.axis.y, rotation.axis.z);
-    glMultMatrixf(rotation.data());
-    // scale with radius
-    glScalef(radius, radius, radius);
+bool Wall::bakeDrawing(golf::DrawMesh &mesh)
+{
+    mesh.setColor(color);
+    mesh.addQuad({corners[0], corners[1], corners[2], corners[3]}, getNormal());
+    return true;
+}
 
-    // color
-    glColor3f(color.x, color.y, color.z);
+bool Wall::sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t)
+{
+    updateWorldData();
+    return golf::sweepSphereQuad(start, motion, radius, worldCorners.data(), t);
+}
+
+bool Cylinder::collide(Sphere &sphere)
+{
+    // height along the axis and offset from it
+    auto axis = toWorldDirection(Vec3(0, 1, 0));
+    auto base = getWorldPosition();
+    auto center = sphere.getWorldPosition();
+    auto sphereRadius = sphere.getRadius();
+    auto offset = center - base;
+    double h = axis.dot(offset);
+    auto radial = offset - axis * h;
+    double r = radial.length();
+
+    if (h < -sphereRadius || h > height + sphereRadius || r > radius + sphereRadius)
+        return false;
 
-    for (float beta = 0.0; beta <= PI - 0.0001; beta += PI / resolution)
+    Vec3 normal;
+    double depth;
+    if (r <= radius && h >= 0 && h <= height)
     {
-        int step = round(beta * resolution / PI + 0.0001);
-        switch (step % 2)
+        // center inside, out through the closest of side, top and bottom
+        double side = radius - r;
+        double top = height - h;
+        if (r > 0 && side <= top && side <= h)
         {
-        case 0:
-            glColor3f(color.x, color.y, color.z);
-            break;
-        case 1:
-            glColor3f(1, 0.7, 1);
-            break;
+            normal = radial / r;
+            depth = side + sphereRadius;
         }
-
-        glBegin(GL_TRIANGLE_STRIP);
-        for (float alpha = 0.0; alpha < 2.01 * PI; alpha += PI / resolution)
+        else if (top <= h)
+        {
+            normal = axis;
+            depth = top + sphereRadius;
+        }
+        else
         {
-            float x = sin(beta) * cos(alpha);
-            float y = sin(beta) * sin(alpha);
-            float z = cos(beta);
-
-            glNormalVec3(Vec3(x, y, z));
-            // glColor3ub( rand()%255, rand()%255, rand()%255 );
-            glVertex3f(x, y, z);
-            x = sin(beta + PI / resolution) * cos(alpha);
-            y = sin(beta + PI / resolution) * sin(alpha);
-            z = cos(beta + PI / resolution);
-
-            glNormalVec3(Vec3(x, y, z));
-            glVertex3f(x, y, z);
+            normal = -axis;
+            depth = h + sphereRadius;
         }
-        glEnd();
+    }
+    else
+    {
+        // closest point on the surface, on the side, an end or the rim between them
+        auto closest = base + axis * std::clamp(h, 0.0, height) + (r > radius ? radial * (radius / r) : radial);
+        auto toCenter = center - closest;
+        double dist = toCenter.length();
+        if (dist >= sphereRadius || dist == 0)
+            return false;
+        normal = toCenter / dist;
+        depth = sphereRadius - dist;
     }
 
+    // only the velocity into the surface is reflected, the round side has no facets to bounce off
+    auto velocity = sphere.getVelocity();
+    double into = velocity.dot(normal);
+    if (into < 0)
+        sphere.setVelocity(velocity - normal * ((1 + bounceFactor) * into));
+
+    sphere.move(normal * (depth + 0.001));
+    return true;
+}
+
+bool Cylinder::getWorldBounds(AABB &bounds)
+{
+    auto axis = toWorldDirection(Vec3(0, 1, 0));
+    auto bottom = getWorldPosition();
+    auto top = bottom + axis * height;
+    // the end circles reach sqrt(1 - axis^2) of the radius along every world axis
+    Vec3 extent(radius * sqrt(std::max(0.0, 1.0 - axis.x * axis.x)),
+                radius * sqrt(std::max(0.0, 1.0 - axis.y * axis.y)),
+                radius * sqrt(std::max(0.0, 1.0 - axis.z * axis.z)));
+    bounds = AABB();
+    bounds.expand(bottom - extent);
+    bounds.expand(bottom + extent);
+    bounds.expand(top - extent);
+    bounds.expand(top + extent);
+    return true;
+}
+
+bool Cylinder::sweep(const Vec3 &start, const Vec3 &motion, double radius, double &t)
+{
+    return golf::sweepSphereCylinder(start, motion, radius, getWorldPosition(), toWorldDirection(Vec3(0, 1, 0)), this->radius, height, t);
+}
+
+void Sphere::draw()
+{
+    drawAt(position);
+}
+
+void Sphere::drawAt(const Vec3 &center)
+{
+    glPushMatrix();
+
+    // position
+    glTranslatef(center.x, center.y, center.z);
+
+    // draw axis if enabled
+    if (showAxis)
+        drawAxes();
+
+    // rotation
+    glMultMatrixf(getOrientationMatrix().data());
+    // scale with radius
+    glScalef(radius, radius, radius);
+
+    // cached unit sphere in the color and the stripes
+    golf::SphereMesh::get(resolution).draw(color);
+
     glPopMatrix();
 
     SimObject::draw();
 }
 
+void Sphere::drawAxes()
+{
+    // draw movement vector
+    auto embiggenedVelocity = velocity.normalizedFast() * radius * 2;
+    glBegin(GL_LINES);
+    glColor3f(1, 0, 0);
+    glVertexNPoints(Vec3(0, 0, 0), embiggenedVelocity);
+    glEnd();
+
+    // draw floor normal
+    auto embiggenedFloorNormal = currentFloorNormal.normalizedFast() * radius * 2;
+    glBegin(GL_LINES);
+    glColor3f(0, 1, 0);
+    glVertexNPoints(Vec3(0, 0, 0), embiggenedFloorNormal);
+    glEnd();
+
+    // draw rotation axis
+    auto embiggenedRotationAxis = currentFloorNormal.cross(velocity).normalizedFast() * radius * 2;
+    glBegin(GL_LINES);
+    glColor3f(0, 0, 1);
+    glVertexNPoints(Vec3(0, 0, 0), embiggenedRotationAxis);
+    glEnd();
+}
+
+void Sphere::bakeInstance(golf::DrawMesh &mesh, const Vec3 &center)
+{
+    QMatrix4x4 transform;
+    transform.translate(center.x, center.y, center.z);
+    transform.rotate(orientation);
+    mesh.setTransform(transform);
+    golf::SphereMesh::get(resolution).bake(mesh, radius, color);
+}
+
 void Sphere::move(Vec3 v)
 {
     if (v.lengthSquared() == 0.0)
@@ -712,18 +1050,49 @@ void Sphere::move(Vec3 v)
         setPosition(this->getPosition() + v);
         return;
     }
-    auto rot = cross.normalized();
+    auto rot = cross.normalizedFast();
 
-    // calculate angle
+    // calculate angle in radians
     // idk why -
-    auto angle = -360.0 * v.length() * (1-v.dot(getFloorNormal())) / (2.0 * PI * radius);
-    QMatrix4x4 rotMatrix;
-    rotMatrix.rotate(angle, rot.x, rot.y, rot.z);
-    rotMatrix *= rotation;
-    rotation = rotMatrix;
+    auto angle = -v.length() * (1-v.dot(getFloorNormal())) / radius;
+    // the moves of one step roll about nearly the same axis, so adding them up is close enough for drawing
+    spin += rot * angle;
     setPosition(this->getPosition() + v);
 }
 
+void Sphere::applySpin()
+{
+    double angle = spin.length();
+    if (angle == 0.0)
+        return;
+
+    auto axis = spin / angle;
+    double s = sin(angle / 2);
+    orientation = QQuaternion(cos(angle / 2), axis.x * s, axis.y * s, axis.z * s) * orientation;
+    // rounding would slowly turn it into something that is no rotation
+    orientation.normalize();
+    spin = Vec3(0);
+}
+
+int Sphere::addStillStep(double distance)
+{
+    const Vec3 &position = getWorldPosition();
+    // a sphere that got away starts over from where it is now
+    if (stillSteps == 0 || (position - stillAnchor).lengthSquared() > distance * distance)
+    {
+        stillAnchor = position;
+        stillSteps = 0;
+    }
+    return ++stillSteps;
+}
+
+QMatrix4x4 Sphere::getOrientationMatrix()
+{
+    QMatrix4x4 matrix;
+    matrix.rotate(orientation);
+    return matrix;
+}
+
 void Sphere::moveTo(Vec3 v)
 {
     auto diff = v - getWorldPosition();
@@ -773,3 +1142,27 @@ void Box::draw()
     glEnd();
     glPopMatrix();
 }
+
+bool Box::bakeDrawing(golf::DrawMesh &mesh)
+{
+    // floor as a fan around the origin
+    mesh.setColor(Vec3(0.5, 0.5, 0.5));
+    for (size_t i = 0; i < outerWallCount; i++)
+    {
+        const auto &corner1 = walls[i].getCorners()[0];
+        const auto &corner2 = walls[(i + 1) % outerWallCount].getCorners()[0];
+        mesh.addTriangle(Vec3(0), corner1, corner2, Vec3(0, 1, 0));
+    }
+
+    // walls are not children, bake them here
+    QMatrix4x4 boxTransform = mesh.getTransform();
+    for (Wall &wall : walls)
+    {
+        QMatrix4x4 wallTransform = boxTransform;
+        wallTransform.translate(wall.getPosition().x, wall.getPosition().y, wall.getPosition().z);
+        mesh.setTransform(wallTransform);
+        wall.bakeDrawing(mesh);
+    }
+    mesh.setTransform(boxTransform);
+    return true;
+}
@@ -3,12 +3,16 @@
 #define SIMULATION_HPP
 
 #include <vector>
-#include <QOpenGLWidget>
+#include <array>
 #include <QOpenGLFunctions>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <math.h>
 
 #include "QMatrix4x4"
+#include "QQuaternion"
+#include "vec3.hpp"
 
 // Helper functions
 inline double randRange(double min, double max)
@@ -22,40 +26,6 @@ constexpr double PI = 3.14159265358979323846;
 // using a fold expression
 
 
-// This is a 3D vector class
-class Vec3 {
-public:
-    double x, y, z;
-    Vec3(double x, double y, double z) : x(x), y(y), z(z) {}
-    Vec3() : x(0), y(0), z(0) {}
-    Vec3(double xyz) : x(xyz), y(xyz), z(xyz) {}
-    Vec3(double x, double z) : x(x), y(0), z(z) {}
-    Vec3 operator+(const Vec3& v) const { return Vec3(x + v.x, y + v.y, z + v.z); }
-    void operator+=(const Vec3& v) { x += v.x; y += v.y; z += v.z; }
-    Vec3 operator-(const Vec3& v) const { return Vec3(x - v.x, y - v.y, z - v.z); }
-    void operator-=(const Vec3& v) { x -= v.x; y -= v.y; z -= v.z; }
-    Vec3 operator*(double s) const { return Vec3(x * s, y * s, z * s); }
-    void operator*=(double s) { x *= s; y *= s; z *= s; }
-    Vec3 operator/(double s) const { return Vec3(x / s, y / s, z / s); }
-    void operator/=(double s) { x /= s; y /= s; z /= s; }
-    Vec3 operator-() const { return Vec3(-x, -y, -z); }
-    bool operator==(const Vec3& v) const { return (x==v.x && y==v.y && z==v.z); }
-    // Dot product
-    double dot(const Vec3& v) const { return x * v.x + y * v.y + z * v.z; }
-    // Cross product
-    Vec3 cross(const Vec3& v) const { return Vec3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
-    double length() const { return sqrt(x * x + y * y + z * z); }
-    double lengthSquared() const { return x * x + y * y + z * z; }
-    // Normalize
-    Vec3 normalized() const { return *this / length(); }
-    // Get distance between two points
-    double getDistance(const Vec3& other);
-    // Get normal of a plane defined by this location and two directions
-    Vec3 getNormal(const Vec3& other1, const Vec3& other2);
-    friend Vec3 operator*(double s, const Vec3& v) { return v * s; }
-};
-
-
 template <typename... Vec3>
 void glVertexNPoints(const Vec3 &...v)
 {
@@ -79,48 +49,176 @@ public:
 
 };
 
+// An axis aligned bounding box
+// A default constructed box is empty and grows with expand()
+class AABB {
+public:
+    Vec3 min;
+    Vec3 max;
+    AABB() : min(std::numeric_limits<Real>::max()), max(-std::numeric_limits<Real>::max()) {}
+    AABB(const Vec3& min, const Vec3& max) : min(min), max(max) {}
+    void expand(const Vec3& p);
+    void expand(const AABB& other);
+    AABB inflated(double margin) const { return AABB(min - Vec3(margin), max + Vec3(margin)); }
+    bool overlaps(const AABB& other) const;
+    bool isEmpty() const { return min.x > max.x; }
+    Vec3 center() const { return (min + max) * 0.5; }
+    double surfaceArea() const;
+};
+
+// Surface properties of a collider, all the collision response needs to know about it
+struct Surface {
+    double bounceFactor = 0.99;
+    double frictionCoefficient = 0;
+};
+
+// Barycentric basis of a triangle a, b, c
+// static geometry computes it once instead of on every face test
+class TriangleBasis {
+public:
+    // c - a and b - a
+    Vec3 v0, v1;
+    double dot00, dot01, dot11;
+    double invDenom;
+    TriangleBasis() : dot00(0), dot01(0), dot11(0), invDenom(0) {}
+    TriangleBasis(const Vec3& a, const Vec3& b, const Vec3& c);
+};
+
+// Plane and edge data of a wall with four corners
+// computed when the wall is baked or moved instead of on every test
+class WallBasis {
+public:
+    Vec3 normal;
+    // unit direction and length of the edge from corner i to corner i + 1
+    std::array<Vec3, 4> edgeDirection;
+    std::array<double, 4> edgeLength;
+    // unit vectors from corner 0 to corner 1 and to corner 3, the normal of both
+    // and one over the extent of the wall along the first two
+    Vec3 axisX, axisY, axisZ;
+    double invExtentX, invExtentY;
+    WallBasis() : edgeLength{}, invExtentX(0), invExtentY(0) {}
+    WallBasis(const Vec3* corners, const Vec3& normal);
+};
+
 class Sphere;
 
+namespace golf {
+    class CollisionMesh;
+    class DrawMesh;
+}
+
 // A simulation object is an abstract class used to represent objects in the simulation
 class SimObject {
 protected:
     double bounceFactor = 0.99;
     double frictionCoefficient = 0;
+    // position relative to the parent, the rotation is below
     Vec3 position;
     SimObject* parent = nullptr;
-    Vec3 worldPosition = Vec3(0);
-    QMatrix4x4 rotation;
     Vec3 velocity;
     Vec3 color;
     double density=1.0;
     std::vector<SimObject*> children;
 
+private:
+    // rotation relative to the parent and in the world
+    // the matrices are only allocated for objects that are rotated or below a rotated one,
+    // which most course objects and all balls never are, copies of an object get their own
+    class Rotation
+    {
+        struct Matrices
+        {
+            QMatrix4x4 local;
+            QMatrix4x4 world;
+        };
+        std::unique_ptr<Matrices> matrices;
+
+    public:
+        Rotation() = default;
+        Rotation(const Rotation& other) : matrices(other.matrices ? new Matrices(*other.matrices) : nullptr) {}
+        Rotation& operator=(const Rotation& other);
+        bool isAllocated() const { return matrices != nullptr; }
+        // the identity if there are no matrices
+        const QMatrix4x4& getLocal() const;
+        const QMatrix4x4& getWorld() const;
+        void setLocal(const QMatrix4x4& local);
+        void setWorld(const QMatrix4x4& world);
+    };
+    Rotation rotation;
+
+    // world transform, only recomputed when it is read after this object or one of its parents moved
+    // moving an object is O(1), its children notice on their next read by comparing versions
+    Vec3 worldPosition;
+    // false while the world rotation is the identity, the rotation matrices are not read then
+    bool worldRotated = false;
+    bool transformDirty = true;
+    // bumped on every recompute of the world transform
+    unsigned long long worldVersion = 0;
+    // version of the parent transform the cached one was computed from
+    unsigned long long parentVersion = 0;
+    void updateWorldTransform();
+
 public:
-    SimObject() : position(0), rotation(), velocity(0), color(1,0,0), density(1) {}
-    SimObject(Vec3 center, double density=1) : position(center), rotation(), velocity(0), color(1,0,0), density(density) {}
+    // draw debug vectors (velocity, floor normal, rotation axis)
+    static bool showAxis;
+
+    // allocated in the arena of the current golf::Arena::Scope if there is one, see golf::buildLevel
+    // delete runs the destructor as usual, but only gives back memory that came from the heap
+    static void* operator new(std::size_t size);
+    static void operator delete(void* p);
+
+    SimObject() : position(0), velocity(0), color(1,0,0), density(1) {}
+    SimObject(Vec3 center, double density=1) : position(center), velocity(0), color(1,0,0), density(density) {}
     virtual ~SimObject() { for (SimObject* child : children) delete child; }
     void setPosition(Vec3 position);
     void setDensity(double density) { this->density = density; }
-    void setRotation(const QMatrix4x4& rotation) { this->rotation = rotation; }
+    void setRotation(const QMatrix4x4& rotation) { this->rotation.setLocal(rotation); transformDirty = true; }
     void setVelocity(Vec3 velocity) { this->velocity = velocity; }
     void setColor(Vec3 color) { this->color = color; }
-    Vec3& getPosition() { return position; }
-    Vec3 getWorldPosition() { return worldPosition + position; }
-    void setWorldPosition(Vec3 worldPosition);
+    const Vec3& getPosition() { return position; }
+    Vec3 getWorldPosition() { updateWorldTransform(); return worldPosition; }
+    const QMatrix4x4& getWorldRotation() { updateWorldTransform(); return rotation.getWorld(); }
+    // a point or a direction given relative to this object in world space
+    Vec3 toWorld(const Vec3& local);
+    Vec3 toWorldDirection(const Vec3& local);
+    // brings the cached transforms of this object and all below it up to date, see updateWorldData
+    // after that they can be read from several threads at once
+    void updateWorldTransforms();
+    // bumped whenever the world transform changes, for caches of data derived from it
+    unsigned long long getWorldVersion() { updateWorldTransform(); return worldVersion; }
+    // refreshes such caches if the transform changed since they were built
+    virtual void updateWorldData() {}
     double getDensity() { return density; }
-    QMatrix4x4& getRotation() { return rotation; }
+    const QMatrix4x4& getRotation() { return rotation.getLocal(); }
     Vec3& getVelocity() { return velocity; }
     Vec3& getColor() { return color; }
     double getBounceFactor() { return bounceFactor; }
     void setBounceFactor(double bounceFactor) { this->bounceFactor = bounceFactor; }
     double calcBounceFactor(const SimObject& other);
+    double calcBounceFactor(const Surface& other);
+    Surface getSurface() const { return {bounceFactor, frictionCoefficient}; }
     void addChild(SimObject* child);
     std::vector<SimObject*>& getChildren() { return children; }
     virtual bool collide(Sphere& sphere);
+    // world space bounds of the collision geometry of this object alone
+    // returns false if the object has no geometry of its own and only its children collide
+    virtual bool getWorldBounds(AABB&) { return false; }
+    // adds the collision geometry of this object to a flat course mesh
+    // returns false if the object can not be baked and has to collide itself
+    virtual bool bake(golf::CollisionMesh&) { return false; }
+    // adds the visible geometry of this object alone to a course vertex array, in the current transform of the mesh
+    // returns false if the object has to be drawn with draw() instead, children included
+    virtual bool bakeDrawing(golf::DrawMesh&) { return true; }
+    // time of impact t in [0, 1] of a sphere moving from start to start + motion, see sweep.hpp
+    // the default takes the earliest impact of the children
+    virtual bool sweep(const Vec3& start, const Vec3& motion, double radius, double& t);
     void applyCollisionVelocity(const Vec3& newVelocity, const Vec3& otherNormal, const SimObject& otherObject);
+    void applyCollisionVelocity(const Vec3& newVelocity, const Vec3& otherNormal, const Surface& otherSurface);
 
     virtual void tick(double time);
     virtual void draw();
+    // draws the object at position instead of its own, for drawing a snapshot
+    virtual void drawAt(const Vec3& position);
     virtual double getMass() { return static_cast<double>(LLONG_MAX); }
 };
 
@@ -138,9 +236,19 @@ public:
     Triangle() : Triangle(Vec3(-1,0,-1), Vec3(1,0,-1), Vec3(0,0,1)) {}
     void draw();
     bool collide(Sphere& sphere);
+    // corner, edge and face test against a triangle given in world space
+    static bool collideWorld(Sphere& sphere, const Vec3* worldCorners, const Vec3& normal, const TriangleBasis& basis, const Surface& surface, bool faceCollisionOnly);
+    // face test of the sphere at center against the triangle with first corner a
+    static bool collideFace(Sphere& sphere, const Vec3& center, const Vec3& sphereVelocity, const Vec3& a, const Vec3& normal, const TriangleBasis& basis, const Surface& surface);
+    bool getWorldBounds(AABB& bounds);
+    bool bake(golf::CollisionMesh& mesh);
+    bool bakeDrawing(golf::DrawMesh& mesh);
+    bool sweep(const Vec3& start, const Vec3& motion, double radius, double& t);
     Vec3 getNormal() { return p1.getNormal(p2, p3); }
+    Vec3 getWorldNormal() { return toWorldDirection(getNormal()); }
+    bool isFaceCollisionOnly() { return faceCollisionOnly; }
     std::vector<Vec3> getCorners() { return {p1, p2, p3}; }
-    std::vector<Vec3> getWorldCorners();
+    std::array<Vec3, 3> getWorldCorners();
 };
 
 // A wall is defined by four corners
@@ -149,6 +257,10 @@ class Wall : public SimObject
 {
 protected:
     std::vector<Vec3> corners;
+    // corners and basis in world space, rebuilt in updateWorldData
+    std::array<Vec3, 4> worldCorners;
+    WallBasis basis;
+    unsigned long long basisVersion = 0;
 
 public:
     Wall(const Vec3& corner1, const Vec3& corner2, const Vec3& corner3, const Vec3& corner4);
@@ -158,9 +270,36 @@ public:
     void draw();
     double getMass() { return 99999999999.9;}
     bool collide(Sphere& sphere);
+    // corner, edge and face test against a wall given in world space
+    static bool collideWorld(Sphere& sphere, const Vec3* worldCorners, const WallBasis& basis);
+    void updateWorldData();
+    bool getWorldBounds(AABB& bounds);
+    bool bake(golf::CollisionMesh& mesh);
+    bool bakeDrawing(golf::DrawMesh& mesh);
+    bool sweep(const Vec3& start, const Vec3& motion, double radius, double& t);
     Vec3 getNormal() { return corners[0].getNormal(corners[1], corners[2]); }
-    std::vector<Vec3>& getCorners() { return corners; }
-    std::vector<Vec3> getWorldCorners();
+    Vec3 getWorldNormal() { return toWorldDirection(getNormal()); }
+    const std::vector<Vec3>& getCorners() { return corners; }
+    const std::array<Vec3, 4>& getWorldCorners() { updateWorldData(); return worldCorners; }
+    const WallBasis& getWorldBasis() { updateWorldData(); return basis; }
+};
+
+// A closed cylinder standing on its position along its local y axis
+// collides with spheres exactly, children are only drawn
+class Cylinder : public SimObject
+{
+protected:
+    double radius;
+    double height;
+
+public:
+    Cylinder(const Vec3& position, double radius, double height) : SimObject(position), radius(radius), height(height) {}
+    double getRadius() { return radius; }
+    double getHeight() { return height; }
+    double getMass() { return 99999999999.9;}
+    bool collide(Sphere& sphere);
+    bool getWorldBounds(AABB& bounds);
+    bool sweep(const Vec3& start, const Vec3& motion, double radius, double& t);
 };
 
 // A sphere is defined by a center and a radius
@@ -172,19 +311,63 @@ protected:
     int resolution;
     // Normal of the floor, used for rolling
     Vec3 currentFloorNormal = Vec3(0,1,0);
+    // world position at the start of the last physics step
+    Vec3 previousPosition;
+    // orientation from rolling, only used for drawing
+    // balls never set the rotation of the SimObject, so they carry no rotation matrices
+    QQuaternion orientation;
+    // rolling collected by move since the last applySpin, the axis scaled by the angle in radians
+    Vec3 spin;
+    // a sleeping sphere is at rest and skipped by the physics until it is woken, see golf::PhysicsWorld
+    bool sleeping = false;
+    // steps in a row the sphere was slow and touching something
+    int restingSteps = 0;
+    // steps in a row the sphere stayed close to stillAnchor, however fast it jittered
+    int stillSteps = 0;
+    Vec3 stillAnchor;
 
 public:
     Sphere() : SimObject(), radius(1), resolution(10) {}
-    Sphere(Vec3 center, double radius, int resolution=10) : SimObject(center), radius(radius), resolution(resolution) {}
+    Sphere(Vec3 center, double radius, int resolution=10) : SimObject(center), radius(radius), resolution(resolution), previousPosition(center) {}
     void setRadius(double radius) { this->radius = radius; }
     void setResolution(int resolution) { this->resolution = resolution; }
     double getRadius() { return radius; }
     int getResolution() { return resolution; }
     void setFloorNormal(Vec3 normal) { currentFloorNormal = normal; }
     Vec3& getFloorNormal() { return currentFloorNormal; }
+    void storePreviousPosition() { previousPosition = getWorldPosition(); }
+    const Vec3& getPreviousPosition() { return previousPosition; }
+    bool isSleeping() { return sleeping; }
+    // stops the sphere where it is
+    void sleep() { sleeping = true; velocity = Vec3(0); }
+    void wake() { sleeping = false; restingSteps = 0; stillSteps = 0; }
+    // returns the number of resting steps in a row including this one
+    int addRestingStep() { return ++restingSteps; }
+    void clearRestingSteps() { restingSteps = 0; }
+    int getRestingSteps() { return restingSteps; }
+    void setRestingSteps(int restingSteps) { this->restingSteps = restingSteps; }
+    // returns the number of steps in a row the sphere stayed within distance of where they started, this one included
+    int addStillStep(double distance);
+    int getStillSteps() { return stillSteps; }
+    const Vec3& getStillAnchor() { return stillAnchor; }
+    void setStill(int stillSteps, const Vec3& stillAnchor) { this->stillSteps = stillSteps; this->stillAnchor = stillAnchor; }
+    // position between the last two steps, alpha 0 is the previous one and 1 the current one
+    Vec3 getInterpolatedPosition(double alpha) { return previousPosition.multiplyAdd(getWorldPosition() - previousPosition, alpha); }
     void draw();
+    void drawAt(const Vec3& center);
+    // debug vectors around the current matrix origin
+    void drawAxes();
+    // drawn on its own, see golf::Course::draw
+    bool bakeDrawing(golf::DrawMesh&) { return false; }
+    // adds the sphere at center to a batch of spheres drawn together
+    void bakeInstance(golf::DrawMesh& mesh, const Vec3& center);
     void move(Vec3 v);
     void moveTo(Vec3 v);
+    // turns the orientation by the collected spin, once per physics step instead of once per move
+    void applySpin();
+    const QQuaternion& getOrientation() { return orientation; }
+    // built when drawn, once per frame
+    QMatrix4x4 getOrientationMatrix();
     double getMass();
     void bounce(Sphere& other);
 
@@ -206,6 +389,7 @@ public:
 
     std::vector<Wall>& getWalls() { return walls; }
     void draw();
+    bool bakeDrawing(golf::DrawMesh& mesh);
     double getMass() { return 99999999999.9;}
     size_t getOuterWallCount() { return outerWallCount; }
 };
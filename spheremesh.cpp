@@ -0,0 +1,94 @@
+#include "spheremesh.hpp"
+#include "drawmesh.hpp"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace golf {
+
+    const Vec3 SphereMesh::stripeColor = Vec3(1, 0.7, 1);
+
+    const SphereMesh& SphereMesh::get(int resolution) {
+        // every ball is baked each frame, once a mesh is built the common resolutions are found without a lock
+        constexpr int tableSize = 64;
+        static std::atomic<const SphereMesh*> table[tableSize];
+        static std::mutex mutex;
+        static std::map<int, std::unique_ptr<SphereMesh>> cache;
+
+        bool inTable = resolution >= 0 && resolution < tableSize;
+        if (inTable) {
+            if (const SphereMesh* mesh = table[resolution].load(std::memory_order_acquire))
+                return *mesh;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& mesh = cache[resolution];
+        if (mesh == nullptr) mesh.reset(new SphereMesh(resolution));
+        if (inTable) table[resolution].store(mesh.get(), std::memory_order_release);
+        return *mesh;
+    }
+
+    SphereMesh::SphereMesh(int resolution) {
+        // same bands as the old immediate mode strips, even ones first
+        std::vector<Vertex> stripes;
+        for (float beta = 0.0; beta <= PI - 0.0001; beta += PI / resolution) {
+            int step = round(beta * resolution / PI + 0.0001);
+            addBand(step % 2 == 0 ? vertices : stripes, beta, resolution);
+        }
+        stripeStart = static_cast<int>(vertices.size());
+        vertices.insert(vertices.end(), stripes.begin(), stripes.end());
+    }
+
+    void SphereMesh::addBand(std::vector<Vertex>& band, float beta, int resolution) {
+        // the strip of one band, turned into separate triangles
+        std::vector<Vertex> strip;
+        for (float alpha = 0.0; alpha < 2.01 * PI; alpha += PI / resolution) {
+            strip.push_back({{
+                static_cast<float>(sin(beta) * cos(alpha)),
+                static_cast<float>(sin(beta) * sin(alpha)),
+                static_cast<float>(cos(beta))}});
+            strip.push_back({{
+                static_cast<float>(sin(beta + PI / resolution) * cos(alpha)),
+                static_cast<float>(sin(beta + PI / resolution) * sin(alpha)),
+                static_cast<float>(cos(beta + PI / resolution))}});
+        }
+        for (size_t i = 2; i < strip.size(); i++) {
+            // every second strip triangle is wound the other way
+            if (i % 2 == 0) {
+                band.push_back(strip[i - 2]);
+                band.push_back(strip[i - 1]);
+            } else {
+                band.push_back(strip[i - 1]);
+                band.push_back(strip[i - 2]);
+            }
+            band.push_back(strip[i]);
+        }
+    }
+
+    void SphereMesh::draw(const Vec3& color) const {
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(Vertex), vertices.data());
+        glNormalPointer(GL_FLOAT, sizeof(Vertex), vertices.data());
+
+        glColor3f(color.x, color.y, color.z);
+        glDrawArrays(GL_TRIANGLES, 0, stripeStart);
+        glColor3f(stripeColor.x, stripeColor.y, stripeColor.z);
+        glDrawArrays(GL_TRIANGLES, stripeStart, static_cast<int>(vertices.size()) - stripeStart);
+
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    }
+
+    void SphereMesh::bake(DrawMesh& mesh, double radius, const Vec3& color) const {
+        mesh.setColor(color);
+        for (size_t i = 0; i < vertices.size(); i++) {
+            if (static_cast<int>(i) == stripeStart) mesh.setColor(stripeColor);
+            const float* p = vertices[i].position;
+            Vec3 normal(p[0], p[1], p[2]);
+            mesh.addVertex(normal * radius, normal);
+        }
+    }
+
+}
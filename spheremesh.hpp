@@ -0,0 +1,48 @@
+#ifndef SPHEREMESH_HPP
+#define SPHEREMESH_HPP
+
+#include <vector>
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    class DrawMesh;
+
+    // unit sphere as a triangle list, built once per resolution and shared by every sphere
+    // the latitude bands alternate between the sphere color and a stripe color
+    class SphereMesh
+    {
+
+    public:
+        struct Vertex
+        {
+            // also the normal on a unit sphere
+            float position[3];
+        };
+
+        static const Vec3 stripeColor;
+
+        // cached mesh for the resolution, built on first use, safe to call from any thread
+        static const SphereMesh &get(int resolution);
+
+        const std::vector<Vertex> &getVertices() const { return vertices; }
+        // vertices before this index belong to the even bands, the rest to the stripes
+        int getStripeStart() const { return stripeStart; }
+
+        // draws the unit sphere in the current matrix, two calls from client memory
+        void draw(const Vec3 &color) const;
+        // adds the sphere scaled to radius to a mesh, in its current transform
+        void bake(DrawMesh &mesh, double radius, const Vec3 &color) const;
+
+    private:
+        std::vector<Vertex> vertices;
+        int stripeStart = 0;
+
+        explicit SphereMesh(int resolution);
+        static void addBand(std::vector<Vertex> &band, float beta, int resolution);
+    };
+
+}
+
+#endif // SPHEREMESH_HPP
@@ -0,0 +1,163 @@
+#include "sweep.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    bool sweepSpherePoint(const Vec3& start, const Vec3& motion, double radius, const Vec3& point, double& t) {
+        // |start + t * motion - point| = radius
+        auto offset = start - point;
+        double a = motion.dot(motion);
+        double b = offset.dot(motion);
+        double c = offset.dot(offset) - radius * radius;
+        // already touching or moving away
+        if (c <= 0 || b >= 0 || a == 0) return false;
+        double discriminant = b * b - a * c;
+        if (discriminant < 0) return false;
+        double hit = (-b - sqrt(discriminant)) / a;
+        if (hit < 0 || hit > 1) return false;
+        t = hit;
+        return true;
+    }
+
+    bool sweepSphereSegment(const Vec3& start, const Vec3& motion, double radius, const Vec3& a, const Vec3& b, double& t) {
+        // intersect the path of the center with the infinite cylinder around the segment,
+        // then check that the contact lies between both ends
+        auto d = b - a;
+        auto offset = start - a;
+        double dd = d.dot(d);
+        double md = motion.dot(d);
+        double od = offset.dot(d);
+        double qa = dd * motion.dot(motion) - md * md;
+        double qb = dd * offset.dot(motion) - od * md;
+        double qc = dd * (offset.dot(offset) - radius * radius) - od * od;
+        // parallel to the segment, the end points catch this case
+        if (qa < 1e-12) return false;
+        // already inside the cylinder or moving away from it
+        if (qc <= 0 || qb >= 0) return false;
+        double discriminant = qb * qb - qa * qc;
+        if (discriminant < 0) return false;
+        double hit = (-qb - sqrt(discriminant)) / qa;
+        if (hit < 0 || hit > 1) return false;
+        double along = (od + hit * md) / dd;
+        if (along < 0 || along > 1) return false;
+        t = hit;
+        return true;
+    }
+
+    bool sweepSphereTriangle(const Vec3& start, const Vec3& motion, double radius, const Vec3& a, const Vec3& b, const Vec3& c, double& t, bool faceOnly) {
+        auto normal = a.getNormal(b, c);
+        double startDist = normal.dot(start - a);
+        double approach = normal.dot(motion);
+
+        // face: the sphere reaches the plane from the side it starts on
+        if (abs(startDist) > radius && startDist * approach < 0) {
+            double side = startDist > 0 ? 1 : -1;
+            double hit = (side * radius - startDist) / approach;
+            if (hit >= 0 && hit <= 1) {
+                // contact point on the plane, inside the triangle means this is the first contact
+                auto p = start + motion * hit - normal * (side * radius);
+                TriangleBasis basis(a, b, c);
+                auto v2 = p - a;
+                double dot02 = basis.v0.dot(v2);
+                double dot12 = basis.v1.dot(v2);
+                double u = (basis.dot11 * dot02 - basis.dot01 * dot12) * basis.invDenom;
+                double v = (basis.dot00 * dot12 - basis.dot01 * dot02) * basis.invDenom;
+                if (u >= 0 && v >= 0 && u + v <= 1) {
+                    t = hit;
+                    return true;
+                }
+            }
+        }
+        else if (abs(startDist) > radius) {
+            // outside the plane band and moving away or parallel, nothing to hit
+            return false;
+        }
+        if (faceOnly) return false;
+
+        // edges and corners, earliest one wins
+        bool found = false;
+        double best = 2;
+        double hit;
+        const Vec3* corners[3] = {&a, &b, &c};
+        for (int i = 0; i < 3; i++) {
+            if (sweepSphereSegment(start, motion, radius, *corners[i], *corners[(i + 1) % 3], hit) && hit < best) {
+                best = hit;
+                found = true;
+            }
+            if (sweepSpherePoint(start, motion, radius, *corners[i], hit) && hit < best) {
+                best = hit;
+                found = true;
+            }
+        }
+        if (found) t = best;
+        return found;
+    }
+
+    bool sweepSphereQuad(const Vec3& start, const Vec3& motion, double radius, const Vec3* corners, double& t) {
+        // split along the diagonal 0-2
+        double hit1, hit2;
+        bool found1 = sweepSphereTriangle(start, motion, radius, corners[0], corners[1], corners[2], hit1);
+        bool found2 = sweepSphereTriangle(start, motion, radius, corners[0], corners[2], corners[3], hit2);
+        if (!found1 && !found2) return false;
+        t = !found2 ? hit1 : !found1 ? hit2 : std::min(hit1, hit2);
+        return true;
+    }
+
+    bool sweepSphereCylinder(const Vec3& start, const Vec3& motion, double radius, const Vec3& base, const Vec3& axis, double cylinderRadius, double height, double& t) {
+        auto offset = start - base;
+        double startHeight = offset.dot(axis);
+        double climb = motion.dot(axis);
+        auto radial = offset - axis * startHeight;
+        auto radialMotion = motion - axis * climb;
+        double reach = cylinderRadius + radius;
+
+        bool found = false;
+        double best = 2;
+
+        // side: the center reaches the cylinder grown by the radius, between both ends
+        double a = radialMotion.dot(radialMotion);
+        double b = radial.dot(radialMotion);
+        double c = radial.dot(radial) - reach * reach;
+        if (c > 0 && b < 0 && a > 0) {
+            double discriminant = b * b - a * c;
+            if (discriminant >= 0) {
+                double hit = (-b - sqrt(discriminant)) / a;
+                double along = startHeight + hit * climb;
+                if (hit >= 0 && hit <= 1 && along >= 0 && along <= height) {
+                    best = hit;
+                    found = true;
+                }
+            }
+        }
+
+        // ends: the sphere reaches the plane of the top from above or of the bottom from below, within the radius
+        if (climb != 0) {
+            double plane = climb < 0 ? height + radius : -radius;
+            bool outside = climb < 0 ? startHeight > plane : startHeight < plane;
+            double hit = (plane - startHeight) / climb;
+            if (outside && hit >= 0 && hit <= 1 && hit < best) {
+                auto p = radial + radialMotion * hit;
+                if (p.dot(p) <= cylinderRadius * cylinderRadius) {
+                    best = hit;
+                    found = true;
+                }
+            }
+        }
+
+        if (found) t = best;
+        return found;
+    }
+
+    bool sweepSphereSphere(const Vec3& start, const Vec3& motion, double radius, const Vec3& otherCenter, double otherRadius, double& t) {
+        // same as a point against the sum of both radii
+        return sweepSpherePoint(start, motion, radius + otherRadius, otherCenter, t);
+    }
+
+    AABB sweptBounds(const Vec3& start, const Vec3& motion, double radius) {
+        AABB bounds;
+        bounds.expand(start);
+        bounds.expand(start + motion);
+        return bounds.inflated(radius);
+    }
+
+}
@@ -0,0 +1,30 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    // swept sphere tests
+    // a sphere of the given radius moves from start to start + motion
+    // each test returns true and the time of impact t in [0, 1] if the sphere touches the shape on the way
+    // a sphere that already touches the shape at start is left to the discrete collision pass
+
+    bool sweepSpherePoint(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 &point, double &t);
+    bool sweepSphereSegment(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 &a, const Vec3 &b, double &t);
+    // faceOnly skips the edges and corners, for triangles whose discrete test only collides with the face
+    bool sweepSphereTriangle(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 &a, const Vec3 &b, const Vec3 &c, double &t, bool faceOnly = false);
+    bool sweepSphereQuad(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 *corners, double &t);
+    // closed cylinder from base along the unit axis, side and flat ends
+    // the rounded rims where they meet are left to the discrete pass
+    bool sweepSphereCylinder(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 &base, const Vec3 &axis, double cylinderRadius, double height, double &t);
+    // both spheres move, motion is the motion of the first one relative to the second one
+    bool sweepSphereSphere(const Vec3 &start, const Vec3 &motion, double radius, const Vec3 &otherCenter, double otherRadius, double &t);
+
+    // bounds of a sphere over its whole motion
+    AABB sweptBounds(const Vec3 &start, const Vec3 &motion, double radius);
+
+}
+
+#endif // SWEEP_HPP
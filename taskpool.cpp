@@ -0,0 +1,140 @@
+#include "taskpool.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace golf {
+
+    namespace {
+        // pool and worker index of the current thread
+        thread_local const TaskPool* threadPool = nullptr;
+        thread_local int threadWorker = -1;
+    }
+
+    TaskPool::TaskPool(int workerCount) {
+        if (workerCount < 0)
+            workerCount = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+
+        for (int i = 0; i < workerCount; i++) {
+            workers.emplace_back(new Worker);
+        }
+        // start only once every deque exists, workers steal from each other right away
+        for (int i = 0; i < workerCount; i++) {
+            workers[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    TaskPool::~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker->thread.join();
+        }
+    }
+
+    TaskPool& TaskPool::getDefault() {
+        static TaskPool pool;
+        return pool;
+    }
+
+    int TaskPool::currentWorker() const {
+        return threadPool == this ? threadWorker : -1;
+    }
+
+    void TaskPool::run(int index) {
+        threadPool = this;
+        threadWorker = index;
+        Profiler::setThreadName("worker " + std::to_string(index));
+
+        Task task;
+        while (true) {
+            if (popOwn(index, task) || steal(index, task)) {
+                execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+            if (stopping && pending.load() == 0) return;
+        }
+    }
+
+    bool TaskPool::popOwn(int index, Task& task) {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.tasks.empty()) return false;
+        task = worker.tasks.back();
+        worker.tasks.pop_back();
+        pending--;
+        return true;
+    }
+
+    bool TaskPool::steal(int thief, Task& task) {
+        int count = static_cast<int>(workers.size());
+        // start at the next worker so thieves spread over the victims
+        for (int i = 1; i <= count; i++) {
+            int victim = (std::max(thief, 0) + i) % count;
+            if (victim == thief) continue;
+            Worker& worker = *workers[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty()) continue;
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+            pending--;
+            return true;
+        }
+        return false;
+    }
+
+    void TaskPool::execute(const Task& task) {
+        for (int i = task.begin; i < task.end; i++) {
+            (*task.body)(i);
+        }
+        task.remaining->fetch_sub(1, std::memory_order_release);
+    }
+
+    void TaskPool::parallelFor(int count, const std::function<void(int)>& body, int grain) {
+        if (count <= 0) return;
+        grain = std::max(grain, 1);
+        int chunks = (count + grain - 1) / grain;
+
+        if (workers.empty() || chunks == 1) {
+            for (int i = 0; i < count; i++) body(i);
+            return;
+        }
+
+        std::atomic<int> remaining(chunks);
+
+        // neighbouring chunks go to the same worker, the others steal if they finish early
+        int workerCount = static_cast<int>(workers.size());
+        for (int w = 0; w < workerCount; w++) {
+            int firstChunk = w * chunks / workerCount;
+            int endChunk = (w + 1) * chunks / workerCount;
+            if (firstChunk == endChunk) continue;
+            Worker& worker = *workers[w];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            // pushed in reverse so the owner pops them in order
+            for (int c = endChunk - 1; c >= firstChunk; c--) {
+                worker.tasks.push_back({&body, c * grain, std::min(count, (c + 1) * grain), &remaining});
+            }
+            pending += endChunk - firstChunk;
+        }
+        {
+            // taking the lock makes sure no worker is between its check and its wait
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+
+        // help until every chunk is done, nested loops keep the workers busy too
+        int self = currentWorker();
+        Task task;
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if ((self >= 0 && popOwn(self, task)) || steal(self, task))
+                execute(task);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+}
@@ -0,0 +1,74 @@
+#ifndef TASKPOOL_HPP
+#define TASKPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace golf
+{
+
+    // a fixed set of worker threads with one task deque each
+    // a worker takes tasks from the back of its own deque and steals from the front of the others when it runs dry,
+    // the thread that starts a parallel loop helps with it until the loop is done
+    class TaskPool
+    {
+
+    public:
+        // -1 uses one worker less than there are hardware threads, the caller is the last one
+        explicit TaskPool(int workerCount = -1);
+        ~TaskPool();
+
+        TaskPool(const TaskPool &) = delete;
+        TaskPool &operator=(const TaskPool &) = delete;
+
+        int getWorkerCount() const { return static_cast<int>(workers.size()); }
+
+        // calls body(i) for every i in [0, count) in chunks of grain indices and returns when all calls are done
+        // runs inline if there are no workers or only one chunk, may be nested
+        void parallelFor(int count, const std::function<void(int)> &body, int grain = 1);
+
+        // pool shared by everything that does not bring its own
+        static TaskPool &getDefault();
+
+    private:
+        struct Task
+        {
+            const std::function<void(int)> *body;
+            int begin;
+            int end;
+            std::atomic<int> *remaining;
+        };
+
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+            std::thread thread;
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        // queued tasks over all deques, workers sleep while it is 0
+        std::atomic<int> pending{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        void run(int index);
+        bool popOwn(int index, Task &task);
+        // index of the thief, -1 for a thread that is not a worker
+        bool steal(int thief, Task &task);
+        void execute(const Task &task);
+        // worker index of the calling thread in this pool, -1 if it is none of ours
+        int currentWorker() const;
+    };
+
+}
+
+#endif // TASKPOOL_HPP
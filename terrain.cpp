@@ -0,0 +1,150 @@
+#include "terrain.hpp"
+#include <algorithm>
+#include "sweep.hpp"
+#include "drawmesh.hpp"
+
+namespace golf {
+
+    HeightfieldTerrain::HeightfieldTerrain(int minXZ, int maxXZ, double resolution, std::function<double(double, double)> heightFunction) : SimObject(), minXZ(minXZ), resolution(resolution) {
+        // same surface properties as GroundTile
+        this->frictionCoefficient = 0.03;
+        this->bounceFactor = 0.8;
+        this->color = Vec3(0.5, 0.7, 0.1);
+
+        // same cell count as the loop in Course::createFloor
+        cells = 0;
+        for (double x = minXZ; x < maxXZ; x += resolution) cells++;
+
+        heights.resize((cells + 1) * (cells + 1));
+        for (int i = 0; i <= cells; i++) {
+            for (int j = 0; j <= cells; j++) {
+                heights[i * (cells + 1) + j] = heightFunction(minXZ + i * resolution, minXZ + j * resolution);
+            }
+        }
+    }
+
+    Vec3 HeightfieldTerrain::getSample(int i, int j) const {
+        return Vec3(minXZ + i * resolution, heights[i * (cells + 1) + j], minXZ + j * resolution);
+    }
+
+    bool HeightfieldTerrain::collideCell(Sphere& sphere, int i, int j) {
+        auto offset = getWorldPosition();
+        Vec3 p1 = getSample(i, j) + offset;
+        Vec3 p2 = getSample(i + 1, j) + offset;
+        Vec3 p3 = getSample(i, j + 1) + offset;
+        Vec3 p4 = getSample(i + 1, j + 1) + offset;
+
+        // same two triangles and winding as createFloor
+        // the sphere is read again for the second one, it may have been pushed out by the first
+        bool collided = collideTriangle(sphere, p3, p1, p2);
+        if (collideTriangle(sphere, p3, p4, p2)) collided = true;
+        return collided;
+    }
+
+    bool HeightfieldTerrain::collideTriangle(Sphere& sphere, const Vec3& a, const Vec3& b, const Vec3& c) {
+        // plane distance first, the basis is only needed when the sphere touches the plane
+        auto normal = a.getNormal(b, c);
+        auto center = sphere.getWorldPosition();
+        if (abs(normal.dot(center - a)) > sphere.getRadius()) return false;
+        return Triangle::collideFace(sphere, center, sphere.getVelocity(), a, normal, TriangleBasis(a, b, c), getSurface());
+    }
+
+    bool HeightfieldTerrain::collide(Sphere& sphere) {
+        // only cells below the sphere can contain the projection of its center
+        // tilted faces shift that projection by at most one radius
+        auto local = sphere.getWorldPosition() - getWorldPosition();
+        double reach = sphere.getRadius() + 0.01;
+        int minI = std::max(0, static_cast<int>(floor((local.x - reach - minXZ) / resolution)));
+        int maxI = std::min(cells - 1, static_cast<int>(floor((local.x + reach - minXZ) / resolution)));
+        int minJ = std::max(0, static_cast<int>(floor((local.z - reach - minXZ) / resolution)));
+        int maxJ = std::min(cells - 1, static_cast<int>(floor((local.z + reach - minXZ) / resolution)));
+
+        bool collided = false;
+        for (int i = minI; i <= maxI; i++) {
+            for (int j = minJ; j <= maxJ; j++) {
+                if (collideCell(sphere, i, j)) collided = true;
+            }
+        }
+
+        return SimObject::collide(sphere) || collided;
+    }
+
+    bool HeightfieldTerrain::sweep(const Vec3& start, const Vec3& motion, double radius, double& t) {
+        // every cell below the swept bounds of the sphere, faces only like collideCell
+        auto offset = getWorldPosition();
+        AABB box = sweptBounds(start - offset, motion, radius + 0.01);
+        int minI = std::max(0, static_cast<int>(floor((box.min.x - minXZ) / resolution)));
+        int maxI = std::min(cells - 1, static_cast<int>(floor((box.max.x - minXZ) / resolution)));
+        int minJ = std::max(0, static_cast<int>(floor((box.min.z - minXZ) / resolution)));
+        int maxJ = std::min(cells - 1, static_cast<int>(floor((box.max.z - minXZ) / resolution)));
+
+        bool found = false;
+        double hit;
+        for (int i = minI; i <= maxI; i++) {
+            for (int j = minJ; j <= maxJ; j++) {
+                Vec3 p1 = getSample(i, j) + offset;
+                Vec3 p2 = getSample(i + 1, j) + offset;
+                Vec3 p3 = getSample(i, j + 1) + offset;
+                Vec3 p4 = getSample(i + 1, j + 1) + offset;
+                if (sweepSphereTriangle(start, motion, radius, p3, p1, p2, hit, true) && (!found || hit < t)) {
+                    t = hit;
+                    found = true;
+                }
+                if (sweepSphereTriangle(start, motion, radius, p3, p4, p2, hit, true) && (!found || hit < t)) {
+                    t = hit;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    bool HeightfieldTerrain::getWorldBounds(AABB& bounds) {
+        auto minmax = std::minmax_element(heights.begin(), heights.end());
+        double maxXZ = minXZ + cells * resolution;
+        auto offset = getWorldPosition();
+        bounds = AABB(Vec3(minXZ, *minmax.first, minXZ) + offset, Vec3(maxXZ, *minmax.second, maxXZ) + offset);
+        return true;
+    }
+
+    void HeightfieldTerrain::draw() {
+        glPushMatrix();
+        glTranslated(position.x, position.y, position.z);
+        glColor3f(color.x, color.y, color.z);
+        glBegin(GL_TRIANGLES);
+        for (int i = 0; i < cells; i++) {
+            for (int j = 0; j < cells; j++) {
+                Vec3 p1 = getSample(i, j);
+                Vec3 p2 = getSample(i + 1, j);
+                Vec3 p3 = getSample(i, j + 1);
+                Vec3 p4 = getSample(i + 1, j + 1);
+                Vec3 n1 = p3.getNormal(p1, p2);
+                glNormal3f(n1.x, n1.y, n1.z);
+                glVertexNPoints(p3, p1, p2);
+                Vec3 n2 = p3.getNormal(p4, p2);
+                glNormal3f(n2.x, n2.y, n2.z);
+                glVertexNPoints(p3, p4, p2);
+            }
+        }
+        glEnd();
+        glPopMatrix();
+
+        SimObject::draw();
+    }
+
+    bool HeightfieldTerrain::bakeDrawing(DrawMesh& mesh) {
+        mesh.setColor(color);
+        for (int i = 0; i < cells; i++) {
+            for (int j = 0; j < cells; j++) {
+                Vec3 p1 = getSample(i, j);
+                Vec3 p2 = getSample(i + 1, j);
+                Vec3 p3 = getSample(i, j + 1);
+                Vec3 p4 = getSample(i + 1, j + 1);
+                mesh.addTriangle(p3, p1, p2, p3.getNormal(p1, p2));
+                mesh.addTriangle(p3, p4, p2, p3.getNormal(p4, p2));
+            }
+        }
+        return true;
+    }
+
+}
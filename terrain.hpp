@@ -0,0 +1,46 @@
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+#include <vector>
+#include <functional>
+#include "simulation.hpp"
+
+namespace golf
+{
+
+    // a regular grid of height samples, the same surface Course::createFloor builds from GroundTiles
+    // samples are stored in one flat array, so the cells under a ball can be found by index
+    // only the world position is applied to it, a rotated terrain would break the lookup by index
+    class HeightfieldTerrain : public SimObject
+    {
+
+    protected:
+        // x and z of the first sample
+        double minXZ;
+        double resolution;
+        // number of cells along x and z, there is one more sample than cells
+        int cells;
+        // heights[i * (cells + 1) + j] is the height at x = minXZ + i * resolution, z = minXZ + j * resolution
+        // stored in the precision of the build, half the size with single precision physics
+        std::vector<Real> heights;
+
+        Vec3 getSample(int i, int j) const;
+        bool collideCell(Sphere& sphere, int i, int j);
+        bool collideTriangle(Sphere& sphere, const Vec3& a, const Vec3& b, const Vec3& c);
+
+    public:
+        HeightfieldTerrain(int minXZ, int maxXZ, double resolution, std::function<double(double, double)> heightFunction);
+
+        int getCellCount() { return cells; }
+        double getResolution() { return resolution; }
+        double getHeight(int i, int j) { return heights[i * (cells + 1) + j]; }
+        bool collide(Sphere& sphere);
+        bool sweep(const Vec3& start, const Vec3& motion, double radius, double& t);
+        bool getWorldBounds(AABB& bounds);
+        void draw();
+        bool bakeDrawing(DrawMesh& mesh);
+    };
+
+}
+
+#endif // TERRAIN_HPP
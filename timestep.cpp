@@ -0,0 +1,23 @@
+#include "timestep.hpp"
+#include <math.h>
+
+namespace golf {
+
+    int FixedTimestep::advance(double elapsed) {
+        if (elapsed > 0) accumulator += elapsed;
+
+        int steps = static_cast<int>(floor(accumulator / step));
+        if (steps > maxSteps) {
+            // too far behind to catch up, slow down instead of spiralling
+            droppedSteps += steps - maxSteps;
+            accumulator -= (steps - maxSteps) * step;
+            steps = maxSteps;
+        }
+        accumulator -= steps * step;
+
+        // rounding can leave a tiny negative rest
+        if (accumulator < 0) accumulator = 0;
+        return steps;
+    }
+
+}
@@ -0,0 +1,40 @@
+#ifndef TIMESTEP_HPP
+#define TIMESTEP_HPP
+
+namespace golf
+{
+
+    // turns real elapsed time into a whole number of fixed physics steps
+    // the time left over is kept for the next call and exposed as an interpolation alpha
+    class FixedTimestep
+    {
+
+    private:
+        double step;
+        // steps run at most per advance, the rest of a backlog is dropped
+        int maxSteps;
+        double accumulator = 0;
+        // number of steps dropped because the simulation fell too far behind
+        unsigned long long droppedSteps = 0;
+
+    public:
+        FixedTimestep(double step, int maxSteps = 5) : step(step), maxSteps(maxSteps) {}
+
+        // adds elapsed seconds and returns how many steps to run now
+        int advance(double elapsed);
+        void reset() { accumulator = 0; }
+
+        double getStep() const { return step; }
+        // step in whole nanoseconds, what the simulation clock is advanced by
+        unsigned long long getStepNanoseconds() const { return static_cast<unsigned long long>(step * 1000 * 1000 * 1000); }
+        int getMaxSteps() const { return maxSteps; }
+        // how far the display is between the last two steps, in [0, 1)
+        double getAlpha() const { return accumulator / step; }
+        // seconds of simulation time until the next step is due
+        double getTimeToNextStep() const { return step - accumulator; }
+        unsigned long long getDroppedSteps() const { return droppedSteps; }
+    };
+
+}
+
+#endif // TIMESTEP_HPP
@@ -0,0 +1,227 @@
+#include "trianglekernel.hpp"
+#include <math.h>
+
+// sse2 is part of every x86-64 cpu, avx2 is compiled with a target attribute and picked at runtime
+#if defined(__x86_64__) || defined(_M_X64)
+#define GOLF_KERNEL_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define GOLF_KERNEL_AVX2
+#define GOLF_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define GOLF_KERNEL_AVX2
+#define GOLF_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+#endif
+
+namespace golf {
+
+    void PackedTriangles::clear() {
+        for (auto* values : {&ax, &ay, &az, &nx, &ny, &nz, &e0x, &e0y, &e0z, &e1x, &e1y, &e1z, &dot00, &dot01, &dot11, &invDenom})
+            values->clear();
+        count = 0;
+    }
+
+    void PackedTriangles::reserve(size_t count) {
+        for (auto* values : {&ax, &ay, &az, &nx, &ny, &nz, &e0x, &e0y, &e0z, &e1x, &e1y, &e1z, &dot00, &dot01, &dot11, &invDenom})
+            values->reserve(count + 3);
+    }
+
+    void PackedTriangles::push(const double* a, const double* n, const double* e0, const double* e1, double d00, double d01, double d11, double inv) {
+        ax.push_back(a[0]);
+        ay.push_back(a[1]);
+        az.push_back(a[2]);
+        nx.push_back(n[0]);
+        ny.push_back(n[1]);
+        nz.push_back(n[2]);
+        e0x.push_back(e0[0]);
+        e0y.push_back(e0[1]);
+        e0z.push_back(e0[2]);
+        e1x.push_back(e1[0]);
+        e1y.push_back(e1[1]);
+        e1z.push_back(e1[2]);
+        dot00.push_back(d00);
+        dot01.push_back(d01);
+        dot11.push_back(d11);
+        invDenom.push_back(inv);
+        count++;
+    }
+
+    void PackedTriangles::pad() {
+        // a batch may start at the last triangle, three more entries keep its loads in bounds
+        for (auto* values : {&ax, &ay, &az, &nx, &ny, &nz, &e0x, &e0y, &e0z, &e1x, &e1y, &e1z, &dot00, &dot01, &dot11, &invDenom})
+            values->resize(count + 3, 0.0);
+    }
+
+    void triangleKernelScalar(const PackedTriangles& t, int first, double cx, double cy, double cz, double radius, TriangleHits& hits) {
+        hits.planeMask = 0;
+        hits.faceMask = 0;
+        for (int lane = 0; lane < 4; lane++) {
+            int i = first + lane;
+
+            // plane distance, normal.dot(center - a)
+            double dx = cx - t.ax[i];
+            double dy = cy - t.ay[i];
+            double dz = cz - t.az[i];
+            double newDist = t.nx[i] * dx + t.ny[i] * dy + t.nz[i] * dz;
+            double dist = fabs(newDist);
+            hits.depth[lane] = radius - dist;
+            if (dist > radius) continue;
+            hits.planeMask |= 1u << lane;
+
+            // closest point on the plane, relative to a
+            double v2x = (cx - t.nx[i] * newDist) - t.ax[i];
+            double v2y = (cy - t.ny[i] * newDist) - t.ay[i];
+            double v2z = (cz - t.nz[i] * newDist) - t.az[i];
+            double dot02 = t.e0x[i] * v2x + t.e0y[i] * v2y + t.e0z[i] * v2z;
+            double dot12 = t.e1x[i] * v2x + t.e1y[i] * v2y + t.e1z[i] * v2z;
+            double u = (t.dot11[i] * dot02 - t.dot01[i] * dot12) * t.invDenom[i];
+            double v = (t.dot00[i] * dot12 - t.dot01[i] * dot02) * t.invDenom[i];
+            if ((u >= 0) && (v >= 0) && (u + v <= 1.0))
+                hits.faceMask |= 1u << lane;
+        }
+    }
+
+#ifdef GOLF_KERNEL_SSE2
+    // two triangles per register, two passes per batch
+    static void triangleKernelSse2(const PackedTriangles& t, int first, double cx, double cy, double cz, double radius, TriangleHits& hits) {
+        const __m128d centerX = _mm_set1_pd(cx);
+        const __m128d centerY = _mm_set1_pd(cy);
+        const __m128d centerZ = _mm_set1_pd(cz);
+        const __m128d r = _mm_set1_pd(radius);
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d one = _mm_set1_pd(1.0);
+
+        hits.planeMask = 0;
+        hits.faceMask = 0;
+        for (int half = 0; half < 2; half++) {
+            int i = first + half * 2;
+            __m128d ax = _mm_loadu_pd(&t.ax[i]);
+            __m128d ay = _mm_loadu_pd(&t.ay[i]);
+            __m128d az = _mm_loadu_pd(&t.az[i]);
+            __m128d nx = _mm_loadu_pd(&t.nx[i]);
+            __m128d ny = _mm_loadu_pd(&t.ny[i]);
+            __m128d nz = _mm_loadu_pd(&t.nz[i]);
+
+            __m128d newDist = _mm_add_pd(_mm_add_pd(_mm_mul_pd(nx, _mm_sub_pd(centerX, ax)), _mm_mul_pd(ny, _mm_sub_pd(centerY, ay))), _mm_mul_pd(nz, _mm_sub_pd(centerZ, az)));
+            __m128d dist = _mm_andnot_pd(signMask, newDist);
+            _mm_storeu_pd(&hits.depth[half * 2], _mm_sub_pd(r, dist));
+            __m128d plane = _mm_cmpngt_pd(dist, r);
+
+            __m128d v2x = _mm_sub_pd(_mm_sub_pd(centerX, _mm_mul_pd(nx, newDist)), ax);
+            __m128d v2y = _mm_sub_pd(_mm_sub_pd(centerY, _mm_mul_pd(ny, newDist)), ay);
+            __m128d v2z = _mm_sub_pd(_mm_sub_pd(centerZ, _mm_mul_pd(nz, newDist)), az);
+            __m128d dot02 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&t.e0x[i]), v2x), _mm_mul_pd(_mm_loadu_pd(&t.e0y[i]), v2y)), _mm_mul_pd(_mm_loadu_pd(&t.e0z[i]), v2z));
+            __m128d dot12 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_loadu_pd(&t.e1x[i]), v2x), _mm_mul_pd(_mm_loadu_pd(&t.e1y[i]), v2y)), _mm_mul_pd(_mm_loadu_pd(&t.e1z[i]), v2z));
+            __m128d d00 = _mm_loadu_pd(&t.dot00[i]);
+            __m128d d01 = _mm_loadu_pd(&t.dot01[i]);
+            __m128d d11 = _mm_loadu_pd(&t.dot11[i]);
+            __m128d inv = _mm_loadu_pd(&t.invDenom[i]);
+            __m128d u = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(d11, dot02), _mm_mul_pd(d01, dot12)), inv);
+            __m128d v = _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(d00, dot12), _mm_mul_pd(d01, dot02)), inv);
+            __m128d inside = _mm_and_pd(_mm_and_pd(_mm_cmpge_pd(u, zero), _mm_cmpge_pd(v, zero)), _mm_cmple_pd(_mm_add_pd(u, v), one));
+
+            unsigned planeBits = _mm_movemask_pd(plane);
+            hits.planeMask |= planeBits << (half * 2);
+            hits.faceMask |= (planeBits & _mm_movemask_pd(inside)) << (half * 2);
+        }
+    }
+#endif
+
+#ifdef GOLF_KERNEL_AVX2
+    // four triangles per register
+    // only avx2 is enabled, not fma, so the products and sums round exactly like the scalar path
+    GOLF_TARGET_AVX2
+    static void triangleKernelAvx2(const PackedTriangles& t, int first, double cx, double cy, double cz, double radius, TriangleHits& hits) {
+        const __m256d centerX = _mm256_set1_pd(cx);
+        const __m256d centerY = _mm256_set1_pd(cy);
+        const __m256d centerZ = _mm256_set1_pd(cz);
+        const __m256d r = _mm256_set1_pd(radius);
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        int i = first;
+        __m256d ax = _mm256_loadu_pd(&t.ax[i]);
+        __m256d ay = _mm256_loadu_pd(&t.ay[i]);
+        __m256d az = _mm256_loadu_pd(&t.az[i]);
+        __m256d nx = _mm256_loadu_pd(&t.nx[i]);
+        __m256d ny = _mm256_loadu_pd(&t.ny[i]);
+        __m256d nz = _mm256_loadu_pd(&t.nz[i]);
+
+        __m256d newDist = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(nx, _mm256_sub_pd(centerX, ax)), _mm256_mul_pd(ny, _mm256_sub_pd(centerY, ay))), _mm256_mul_pd(nz, _mm256_sub_pd(centerZ, az)));
+        __m256d dist = _mm256_andnot_pd(signMask, newDist);
+        _mm256_storeu_pd(hits.depth, _mm256_sub_pd(r, dist));
+        __m256d plane = _mm256_cmp_pd(dist, r, _CMP_NGT_UQ);
+
+        __m256d v2x = _mm256_sub_pd(_mm256_sub_pd(centerX, _mm256_mul_pd(nx, newDist)), ax);
+        __m256d v2y = _mm256_sub_pd(_mm256_sub_pd(centerY, _mm256_mul_pd(ny, newDist)), ay);
+        __m256d v2z = _mm256_sub_pd(_mm256_sub_pd(centerZ, _mm256_mul_pd(nz, newDist)), az);
+        __m256d dot02 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&t.e0x[i]), v2x), _mm256_mul_pd(_mm256_loadu_pd(&t.e0y[i]), v2y)), _mm256_mul_pd(_mm256_loadu_pd(&t.e0z[i]), v2z));
+        __m256d dot12 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(&t.e1x[i]), v2x), _mm256_mul_pd(_mm256_loadu_pd(&t.e1y[i]), v2y)), _mm256_mul_pd(_mm256_loadu_pd(&t.e1z[i]), v2z));
+        __m256d d00 = _mm256_loadu_pd(&t.dot00[i]);
+        __m256d d01 = _mm256_loadu_pd(&t.dot01[i]);
+        __m256d d11 = _mm256_loadu_pd(&t.dot11[i]);
+        __m256d inv = _mm256_loadu_pd(&t.invDenom[i]);
+        __m256d u = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(d11, dot02), _mm256_mul_pd(d01, dot12)), inv);
+        __m256d v = _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(d00, dot12), _mm256_mul_pd(d01, dot02)), inv);
+        __m256d inside = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(u, zero, _CMP_GE_OQ), _mm256_cmp_pd(v, zero, _CMP_GE_OQ)), _mm256_cmp_pd(_mm256_add_pd(u, v), one, _CMP_LE_OQ));
+
+        unsigned planeBits = _mm256_movemask_pd(plane);
+        hits.planeMask = planeBits;
+        hits.faceMask = planeBits & _mm256_movemask_pd(inside);
+    }
+
+    static bool cpuHasAvx2() {
+#if defined(__GNUC__)
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        // avx2 flag and os support for the ymm registers
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#endif
+    }
+#endif
+
+    struct KernelChoice {
+        TriangleKernel kernel;
+        const char* name;
+    };
+
+    static KernelChoice selectTriangleKernel() {
+#ifdef GOLF_KERNEL_AVX2
+        if (cpuHasAvx2()) return {triangleKernelAvx2, "avx2"};
+#endif
+#ifdef GOLF_KERNEL_SSE2
+        return {triangleKernelSse2, "sse2"};
+#else
+        return {triangleKernelScalar, "scalar"};
+#endif
+    }
+
+    static const KernelChoice& getKernelChoice() {
+        static const KernelChoice choice = selectTriangleKernel();
+        return choice;
+    }
+
+    TriangleKernel getTriangleKernel() {
+        return getKernelChoice().kernel;
+    }
+
+    const char* getTriangleKernelName() {
+        return getKernelChoice().name;
+    }
+
+}
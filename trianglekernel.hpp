@@ -0,0 +1,62 @@
+#ifndef TRIANGLEKERNEL_HPP
+#define TRIANGLEKERNEL_HPP
+
+#include <vector>
+#include <cstddef>
+
+namespace golf
+{
+
+    // the data of the sphere vs triangle face test, one array per component
+    // so four triangles can be loaded into one register per component
+    class PackedTriangles
+    {
+
+    public:
+        // first corner
+        std::vector<double> ax, ay, az;
+        // normal
+        std::vector<double> nx, ny, nz;
+        // barycentric basis, c - a and b - a
+        std::vector<double> e0x, e0y, e0z;
+        std::vector<double> e1x, e1y, e1z;
+        std::vector<double> dot00, dot01, dot11, invDenom;
+
+        void clear();
+        // room for count triangles and the padding, so pushing them does not overallocate
+        void reserve(size_t count);
+        // number of real triangles, the arrays carry a few zero entries more
+        // so a batch of four can always be loaded
+        size_t size() const { return count; }
+        void push(const double* a, const double* n, const double* e0, const double* e1, double d00, double d01, double d11, double inv);
+        void pad();
+
+    private:
+        size_t count = 0;
+    };
+
+    // result of testing one sphere against a batch of four triangles
+    struct TriangleHits
+    {
+        // bit i: triangle i is within one radius of the plane
+        unsigned planeMask = 0;
+        // bit i: the center also projects into triangle i
+        unsigned faceMask = 0;
+        // radius minus plane distance per triangle, positive when penetrating
+        double depth[4];
+    };
+
+    // tests the sphere against the four triangles starting at first
+    // computes the same expressions in the same order as Triangle::collideWorld
+    // and Triangle::collideFace, so the masks always agree with the scalar path
+    typedef void (*TriangleKernel)(const PackedTriangles &triangles, int first, double cx, double cy, double cz, double radius, TriangleHits &hits);
+
+    void triangleKernelScalar(const PackedTriangles &triangles, int first, double cx, double cy, double cz, double radius, TriangleHits &hits);
+
+    // the fastest kernel the cpu supports, checked once at runtime
+    TriangleKernel getTriangleKernel();
+    const char *getTriangleKernelName();
+
+}
+
+#endif // TRIANGLEKERNEL_HPP
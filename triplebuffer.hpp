@@ -0,0 +1,46 @@
+#ifndef TRIPLEBUFFER_HPP
+#define TRIPLEBUFFER_HPP
+
+#include <atomic>
+
+namespace golf
+{
+
+    // lock-free handoff of a value from one writer thread to one reader thread
+    // the writer fills its buffer and publishes it, the reader picks up the newest published one
+    // neither side ever waits, the writer may publish any number of times between two reads
+    template <typename T>
+    class TripleBuffer
+    {
+
+    private:
+        static constexpr unsigned indexMask = 3;
+        // set on the shared index when it holds a buffer the reader has not seen yet
+        static constexpr unsigned fresh = 4;
+
+        T buffers[3];
+        // only touched by the writer
+        unsigned back = 0;
+        // handed back and forth between both threads
+        std::atomic<unsigned> shared{1};
+        // only touched by the reader
+        unsigned front = 2;
+
+    public:
+        // writer side, the buffer still holds whatever was written into it two publishes ago
+        T &getWriteBuffer() { return buffers[back]; }
+        void publish() { back = shared.exchange(back | fresh, std::memory_order_acq_rel) & indexMask; }
+
+        // reader side, returns true if a newer buffer was taken
+        bool update()
+        {
+            if (!(shared.load(std::memory_order_relaxed) & fresh)) return false;
+            front = shared.exchange(front, std::memory_order_acq_rel) & indexMask;
+            return true;
+        }
+        const T &getReadBuffer() const { return buffers[front]; }
+    };
+
+}
+
+#endif // TRIPLEBUFFER_HPP
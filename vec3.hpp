@@ -0,0 +1,190 @@
+#ifndef VEC3_HPP
+#define VEC3_HPP
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define VEC3_SSE
+#endif
+
+// multiplyAdd only fuses where the target does it in hardware, std::fma is a slow library call otherwise
+#if defined(__FMA__) || defined(FP_FAST_FMA) || defined(FP_FAST_FMAF)
+#define VEC3_FMA
+#endif
+#if defined(VEC3_SSE) && defined(__FMA__)
+#include <immintrin.h>
+#define VEC3_SSE_FMA
+#endif
+
+// tag for the packed single precision vector, see Vec3T<Packed4f>
+struct Packed4f {};
+
+// 1 / sqrt(v), single precision uses the hardware estimate and one newton step
+inline double inverseSqrt(double v) { return 1.0 / std::sqrt(v); }
+inline float inverseSqrt(float v)
+{
+#ifdef VEC3_SSE
+    float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(v)));
+    return estimate * (1.5f - 0.5f * v * estimate * estimate);
+#else
+    return 1.0f / std::sqrt(v);
+#endif
+}
+
+// This is a 3D vector class
+// T is the precision of the components, Vec3 is the one the build picked, see below
+template <typename T>
+class Vec3T {
+public:
+    typedef T value_type;
+    T x, y, z;
+    Vec3T(T x, T y, T z) : x(x), y(y), z(z) {}
+    Vec3T() : x(0), y(0), z(0) {}
+    Vec3T(T xyz) : x(xyz), y(xyz), z(xyz) {}
+    Vec3T(T x, T z) : x(x), y(0), z(z) {}
+    // between precisions only on request
+    template <typename U>
+    explicit Vec3T(const Vec3T<U>& v) : x(static_cast<T>(v.x)), y(static_cast<T>(v.y)), z(static_cast<T>(v.z)) {}
+    Vec3T operator+(const Vec3T& v) const { return Vec3T(x + v.x, y + v.y, z + v.z); }
+    void operator+=(const Vec3T& v) { x += v.x; y += v.y; z += v.z; }
+    Vec3T operator-(const Vec3T& v) const { return Vec3T(x - v.x, y - v.y, z - v.z); }
+    void operator-=(const Vec3T& v) { x -= v.x; y -= v.y; z -= v.z; }
+    Vec3T operator*(T s) const { return Vec3T(x * s, y * s, z * s); }
+    void operator*=(T s) { x *= s; y *= s; z *= s; }
+    Vec3T operator/(T s) const { return Vec3T(x / s, y / s, z / s); }
+    void operator/=(T s) { x /= s; y /= s; z /= s; }
+    Vec3T operator-() const { return Vec3T(-x, -y, -z); }
+    bool operator==(const Vec3T& v) const { return (x==v.x && y==v.y && z==v.z); }
+    // Dot product
+    T dot(const Vec3T& v) const { return x * v.x + y * v.y + z * v.z; }
+    // Cross product
+    Vec3T cross(const Vec3T& v) const { return Vec3T(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+    T length() const { return std::sqrt(x * x + y * y + z * z); }
+    T lengthSquared() const { return x * x + y * y + z * z; }
+    // Normalize
+    Vec3T normalized() const { return *this / length(); }
+    // multiplies by the inverse square root instead of dividing by the length
+    // not bit for bit the same as normalized, see physicsNormalized for where it is used
+    Vec3T normalizedFast() const { return *this * inverseSqrt(lengthSquared()); }
+    // this + v * s, rounded once where the target has fma
+    Vec3T multiplyAdd(const Vec3T& v, T s) const
+    {
+#ifdef VEC3_FMA
+        return Vec3T(std::fma(v.x, s, x), std::fma(v.y, s, y), std::fma(v.z, s, z));
+#else
+        return *this + v * s;
+#endif
+    }
+    // Get distance between two points
+    T getDistance(const Vec3T& other) const { return (*this - other).length(); }
+    // Get normal of a plane defined by this location and two directions
+    Vec3T getNormal(const Vec3T& other1, const Vec3T& other2) const { return (other1 - *this).cross(other2 - *this).normalized(); }
+    friend Vec3T operator*(T s, const Vec3T& v) { return v * s; }
+};
+
+// single precision packed into one 16 byte sse register, the fourth lane is kept at 0
+// same interface as the scalar vectors, without sse it falls back to plain floats
+template <>
+class alignas(16) Vec3T<Packed4f> {
+public:
+    typedef float value_type;
+    float x, y, z, w;
+    Vec3T(float x, float y, float z) : x(x), y(y), z(z), w(0) {}
+    Vec3T() : x(0), y(0), z(0), w(0) {}
+    Vec3T(float xyz) : x(xyz), y(xyz), z(xyz), w(0) {}
+    Vec3T(float x, float z) : x(x), y(0), z(z), w(0) {}
+    template <typename U>
+    explicit Vec3T(const Vec3T<U>& v) : x(static_cast<float>(v.x)), y(static_cast<float>(v.y)), z(static_cast<float>(v.z)), w(0) {}
+
+#ifdef VEC3_SSE
+    explicit Vec3T(__m128 v) { _mm_store_ps(&x, v); }
+    __m128 load() const { return _mm_load_ps(&x); }
+    Vec3T operator+(const Vec3T& v) const { return Vec3T(_mm_add_ps(load(), v.load())); }
+    Vec3T operator-(const Vec3T& v) const { return Vec3T(_mm_sub_ps(load(), v.load())); }
+    Vec3T operator*(float s) const { return Vec3T(_mm_mul_ps(load(), _mm_set1_ps(s))); }
+    Vec3T operator/(float s) const { return Vec3T(_mm_div_ps(load(), _mm_set1_ps(s))); }
+    Vec3T operator-() const { return Vec3T(_mm_sub_ps(_mm_setzero_ps(), load())); }
+    float dot(const Vec3T& v) const
+    {
+        __m128 p = _mm_mul_ps(load(), v.load());
+        // the fourth lane is 0 in both, so all four can be summed
+        __m128 s = _mm_add_ps(p, _mm_movehl_ps(p, p));
+        s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+        return _mm_cvtss_f32(s);
+    }
+    Vec3T cross(const Vec3T& v) const
+    {
+        __m128 a = load(), b = v.load();
+        __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+        return Vec3T(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+    }
+    Vec3T normalizedFast() const
+    {
+        float squared = dot(*this);
+        __m128 estimate = _mm_rsqrt_ps(_mm_set1_ps(squared));
+        // one newton step brings the estimate to about 22 bits
+        __m128 half = _mm_mul_ps(_mm_set1_ps(0.5f * squared), _mm_mul_ps(estimate, estimate));
+        estimate = _mm_mul_ps(estimate, _mm_sub_ps(_mm_set1_ps(1.5f), half));
+        return Vec3T(_mm_mul_ps(load(), estimate));
+    }
+#ifdef VEC3_SSE_FMA
+    Vec3T multiplyAdd(const Vec3T& v, float s) const { return Vec3T(_mm_fmadd_ps(v.load(), _mm_set1_ps(s), load())); }
+#else
+    Vec3T multiplyAdd(const Vec3T& v, float s) const { return *this + v * s; }
+#endif
+#else
+    Vec3T operator+(const Vec3T& v) const { return Vec3T(x + v.x, y + v.y, z + v.z); }
+    Vec3T operator-(const Vec3T& v) const { return Vec3T(x - v.x, y - v.y, z - v.z); }
+    Vec3T operator*(float s) const { return Vec3T(x * s, y * s, z * s); }
+    Vec3T operator/(float s) const { return Vec3T(x / s, y / s, z / s); }
+    Vec3T operator-() const { return Vec3T(-x, -y, -z); }
+    float dot(const Vec3T& v) const { return x * v.x + y * v.y + z * v.z; }
+    Vec3T cross(const Vec3T& v) const { return Vec3T(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+    Vec3T normalizedFast() const { return *this * inverseSqrt(dot(*this)); }
+    Vec3T multiplyAdd(const Vec3T& v, float s) const { return *this + v * s; }
+#endif
+
+    void operator+=(const Vec3T& v) { *this = *this + v; }
+    void operator-=(const Vec3T& v) { *this = *this - v; }
+    void operator*=(float s) { *this = *this * s; }
+    void operator/=(float s) { *this = *this / s; }
+    bool operator==(const Vec3T& v) const { return (x==v.x && y==v.y && z==v.z); }
+    float length() const { return std::sqrt(dot(*this)); }
+    float lengthSquared() const { return dot(*this); }
+    Vec3T normalized() const { return *this / length(); }
+    float getDistance(const Vec3T& other) const { return (*this - other).length(); }
+    Vec3T getNormal(const Vec3T& other1, const Vec3T& other2) const { return (other1 - *this).cross(other2 - *this).normalized(); }
+    friend Vec3T operator*(float s, const Vec3T& v) { return v * s; }
+};
+
+typedef Vec3T<float> Vec3f;
+typedef Vec3T<double> Vec3d;
+typedef Vec3T<Packed4f> Vec3p;
+
+// precision of the simulation and everything built on it, picked per build
+// GOLF_FLOAT_PHYSICS stores single precision, GOLF_PACKED_PHYSICS the packed sse vectors,
+// the default is double, which replays and the tuned courses are recorded with
+#if defined(GOLF_PACKED_PHYSICS)
+typedef Vec3p Vec3;
+#elif defined(GOLF_FLOAT_PHYSICS)
+typedef Vec3f Vec3;
+#else
+typedef Vec3d Vec3;
+#endif
+typedef Vec3::value_type Real;
+
+// collision normals and reflections of the physics go through these
+// the single precision builds take the fast versions, the default double build stays on the exact ops,
+// a replay has to come out the same bit for bit
+#if defined(GOLF_PACKED_PHYSICS) || defined(GOLF_FLOAT_PHYSICS)
+inline Vec3 physicsNormalized(const Vec3& v) { return v.normalizedFast(); }
+inline Vec3 physicsMultiplyAdd(const Vec3& a, const Vec3& v, Real s) { return a.multiplyAdd(v, s); }
+#else
+inline Vec3 physicsNormalized(const Vec3& v) { return v.normalized(); }
+inline Vec3 physicsMultiplyAdd(const Vec3& a, const Vec3& v, Real s) { return a + v * s; }
+#endif
+
+#endif // VEC3_HPP